@@ -0,0 +1,253 @@
+#ifndef MOTOR_OPENING_BOOK_HPP
+#define MOTOR_OPENING_BOOK_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../chess_board/board.hpp"
+#include "../chess_board/polyglot_keys.hpp"
+#include "../move_generation/move_list.hpp"
+#include "../move_generation/move_generator.hpp"
+#include "../executioner/makemove.hpp"
+#include "../tablebase/mapped_file.hpp"
+
+// Entries are stored as in Polyglot .bin books: 16 bytes big endian, key, move, weight and learn, sorted by key
+constexpr std::size_t BOOK_ENTRY_SIZE = 16;
+
+// The Polyglot key of a position, computed from the board with the Random64 table. The en passant file only counts when
+// a pawn of the side to move can capture on the square, like Polyglot does.
+std::uint64_t book_key(const board & chessboard) {
+    using namespace polyglot_keys;
+    std::uint64_t key = 0;
+
+    for (const Color color : {White, Black}) {
+        for (const Piece piece : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+            const int kind = 2 * piece + (color == White);
+            for (std::uint64_t pieces = chessboard.get_pieces(color, piece); pieces;) {
+                key ^= random64[64 * kind + pop_lsb(pieces)];
+            }
+        }
+    }
+
+    constexpr CastlingRight rights[] = {CASTLE_WHITE_KINGSIDE, CASTLE_WHITE_QUEENSIDE, CASTLE_BLACK_KINGSIDE, CASTLE_BLACK_QUEENSIDE};
+    for (int i = 0; i < 4; i++) {
+        if (chessboard.can_castle(rights[i])) {
+            key ^= random64[castling_offset + i];
+        }
+    }
+
+    const Square enpassant = chessboard.enpassant_square();
+    const Color side = chessboard.get_side();
+    if (enpassant != Null_Square && (PAWN_ATTACKS_TABLE[!side][enpassant] & chessboard.get_pieces(side, Pawn))) {
+        key ^= random64[enpassant_offset + (enpassant & 7)];
+    }
+
+    if (side == White) {
+        key ^= random64[turn_offset];
+    }
+    return key;
+}
+
+// keys of the Polyglot specification, the first one is the start position
+void book_key_test() {
+    const std::vector<std::pair<std::string, std::uint64_t>> book_key_tests = {
+            {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9c},
+            {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196},
+            {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0},
+            {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4},
+            {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78},
+            {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652a607ca3f242c1},
+            {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9},
+            {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3c8123ea7b067637},
+            {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560}
+    };
+
+    int correct = 0;
+    for (const auto & [fen, expected] : book_key_tests) {
+        const board chessboard(fen);
+        if (book_key(chessboard) != expected) {
+            std::cout << "Fen: " << fen << ", expected key: " << std::hex << expected << ", calculated key: " << book_key(chessboard) << std::dec << std::endl;
+        } else {
+            correct++;
+        }
+    }
+
+    std::cout << "Passed " << correct << " book keys correctly out of " << book_key_tests.size() << std::endl;
+}
+
+// to square, from square and promotion piece, castling is written as the king capturing its rook
+std::uint16_t book_move(const chess_move & move) {
+    const int from = move.get_from();
+    int to = move.get_to();
+    int promotion = 0;
+
+    if (move.get_move_type() == CASTLING) {
+        to = to > from ? from + 3 : from - 4;
+    } else if (move.get_move_type() == PROMOTION) {
+        promotion = move.get_promotion() - Knight + 1;
+    }
+    return static_cast<std::uint16_t>(to | from << 6 | promotion << 12);
+}
+
+class opening_book {
+public:
+    bool load(const std::string & path) {
+        file = std::make_unique<mapped_file>();
+        if (!file->open(path) || file->size() % BOOK_ENTRY_SIZE != 0) {
+            file.reset();
+            return false;
+        }
+        return true;
+    }
+
+    // OwnBook, the book is only played from when it is set and a book is loaded
+    void set_own_book(bool enabled) {
+        own_book = enabled;
+    }
+
+    // BookBestMove, the heaviest move instead of one drawn by weight
+    void set_best_move(bool enabled) {
+        best_move = enabled;
+    }
+
+    [[nodiscard]] bool active() const {
+        return own_book && file;
+    }
+
+    // a legal book move for the position
+    bool probe(board & chessboard, chess_move & move) {
+        if (!active()) {
+            return false;
+        }
+
+        const std::uint64_t key = book_key(chessboard);
+        std::size_t low = 0;
+        std::size_t high = file->size() / BOOK_ENTRY_SIZE;
+        while (low < high) {
+            const std::size_t middle = (low + high) / 2;
+            if (read(middle * BOOK_ENTRY_SIZE, 8) < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        stack_move_list moves;
+        chessboard.get_side() == White ? generate_all_moves<White>(chessboard, moves) : generate_all_moves<Black>(chessboard, moves);
+
+        std::vector<std::pair<chess_move, std::uint16_t>> candidates;
+        std::uint32_t total_weight = 0;
+        for (std::size_t entry = low; entry < file->size() / BOOK_ENTRY_SIZE && read(entry * BOOK_ENTRY_SIZE, 8) == key; entry++) {
+            const auto encoded = static_cast<std::uint16_t>(read(entry * BOOK_ENTRY_SIZE + 8, 2));
+            const auto weight = static_cast<std::uint16_t>(read(entry * BOOK_ENTRY_SIZE + 10, 2));
+
+            for (const chess_move & legal : moves) {
+                if (book_move(legal) == encoded && weight > 0) {
+                    candidates.emplace_back(legal, weight);
+                    total_weight += weight;
+                }
+            }
+        }
+
+        if (candidates.empty()) {
+            return false;
+        }
+
+        if (best_move) {
+            move = std::ranges::max_element(candidates, {}, &std::pair<chess_move, std::uint16_t>::second)->first;
+            return true;
+        }
+
+        std::uint32_t pick = std::uniform_int_distribution<std::uint32_t>(0, total_weight - 1)(random);
+        for (const auto & [candidate, weight] : candidates) {
+            if (pick < weight) {
+                move = candidate;
+                break;
+            }
+            pick -= weight;
+        }
+        return true;
+    }
+
+private:
+    std::unique_ptr<mapped_file> file;
+    std::mt19937_64 random{std::random_device{}()};
+    bool own_book = false;
+    bool best_move = false;
+
+    [[nodiscard]] std::uint64_t read(std::size_t offset, int bytes) const {
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = value << 8 | file->data()[offset + i];
+        }
+        return value;
+    }
+};
+
+opening_book book;
+
+// Builds a book from a file of games, one line of moves from the start position per game. Each move gets the number
+// of games that played it in the position as its weight, moves after max_plies are not stored.
+bool make_book(const std::string & input, const std::string & output, int max_plies) {
+    std::ifstream games(input);
+    if (!games) {
+        return false;
+    }
+
+    std::map<std::pair<std::uint64_t, std::uint16_t>, std::uint32_t> counts;
+    board chessboard;
+    std::string line;
+
+    while (std::getline(games, line)) {
+        chessboard.fen_to_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        std::stringstream move_stream(line);
+        std::string move_string;
+
+        for (int ply = 0; ply < max_plies && move_stream >> move_string; ply++) {
+            stack_move_list moves;
+            chessboard.get_side() == White ? generate_all_moves<White>(chessboard, moves) : generate_all_moves<Black>(chessboard, moves);
+
+            chess_move played;
+            for (const chess_move & move : moves) {
+                if (move.to_string() == move_string) {
+                    played = move;
+                }
+            }
+            if (played.get_value() == 0) {
+                break;
+            }
+
+            counts[{book_key(chessboard), book_move(played)}]++;
+            chessboard.get_side() == White ? make_move<White, false>(chessboard, played) : make_move<Black, false>(chessboard, played);
+        }
+    }
+
+    // heaviest move first within a position, as Polyglot tools write them
+    std::vector<std::pair<std::pair<std::uint64_t, std::uint16_t>, std::uint32_t>> entries(counts.begin(), counts.end());
+    std::ranges::stable_sort(entries, [](const auto & a, const auto & b) {
+        return a.first.first != b.first.first ? a.first.first < b.first.first : a.second > b.second;
+    });
+
+    std::ofstream file(output, std::ios::binary);
+    for (const auto & [position, count] : entries) {
+        const auto [key, move] = position;
+        const std::uint64_t fields[] = {key, move, std::min<std::uint32_t>(count, 0xFFFF), 0};
+        const int sizes[] = {8, 2, 2, 4};
+
+        for (int field = 0; field < 4; field++) {
+            for (int byte = sizes[field] - 1; byte >= 0; byte--) {
+                file.put(static_cast<char>(fields[field] >> (8 * byte)));
+            }
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+#endif //MOTOR_OPENING_BOOK_HPP
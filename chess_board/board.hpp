@@ -1,6 +1,7 @@
 #ifndef MOTOR_BOARD_HPP
 #define MOTOR_BOARD_HPP
 
+#include <algorithm>
 #include <sstream>
 #include <tuple>
 #include <vector>
@@ -13,6 +14,7 @@
 #include "zobrist.hpp"
 #include "fen_utilities.hpp"
 #include "pinmask.hpp"
+#include "cuckoo.hpp"
 
 #include "../evaluation/nnue.hpp"
 
@@ -27,6 +29,17 @@ constexpr int castling_mask[64] = {
         7, 15, 15, 15,  3, 15, 15, 11,
 };
 
+// contribution of each piece type to the game phase, 24 with all pieces on the board
+constexpr std::array<std::uint8_t, 6> phase_values = {0, 1, 1, 2, 4, 0};
+
+// Which of the derived fields of board_info are up to date for the position
+enum DerivedState : std::uint8_t {
+    THREATS_VALID  = 1,
+    CHECKERS_VALID = 2, // checkers and checkmask
+    PINS_VALID     = 4, // pin_diagonal and pin_orthogonal
+    CHECKS_VALID   = 8, // check_squares and discovered_blockers
+};
+
 struct board_info {
     std::uint8_t castling_rights = {};
     Square enpassant = Square::Null_Square;
@@ -38,11 +51,17 @@ struct board_info {
     zobrist minor_key = {};
     zobrist major_key = {};
     std::array<zobrist, 2> nonpawn_key = {};
+    zobrist material_key = {}; // keyed by the piece counts, psqt key of the count stands in for the square
+    std::array<std::array<std::uint8_t, 6>, 2> piece_counts = {};
+    std::uint8_t phase = {};
     std::uint64_t threats = {};
     std::uint64_t checkers = {};
     std::uint64_t checkmask = {};
     std::uint64_t pin_diagonal = {};
     std::uint64_t pin_orthogonal = {};
+    std::array<std::uint64_t, 6> check_squares = {}; // squares from which a piece type of side to move attacks enemy king
+    std::uint64_t discovered_blockers = {};           // pieces of side to move that block a check on enemy king
+    std::uint8_t derived = {}; // DerivedState flags, derived fields are computed lazily on first query
 };
 
 class board {
@@ -51,22 +70,44 @@ class board {
     std::array<std::uint64_t, 2> side_occupancy; // occupancy bitboards
     std::uint64_t occupancy;
     board_info * state;
-    std::array<board_info, 384> history;
+    std::array<board_info, 512> history; // ring buffer of the states of the game and the search
+    int state_index;                     // plies played since the fen, the current state is history[state_index % size]
+    std::array<std::uint16_t, 1024> key_filter; // counts of the hash keys of the earlier states by their low bits
     Color  side; // side to move
 public:
     board (const std::string & fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
-            : bitboards{}, side_occupancy{}, occupancy{}, history {}, side {Color::White}  {
+            : bitboards{}, side_occupancy{}, occupancy{}, history {}, state_index{}, key_filter{}, side {Color::White}  {
         state = &history[0];
         std::ranges::fill(pieces, Piece::Null_Piece);
         fen_to_board(fen);
     }
 
+    // state points into the history, a copy has to point into its own
+    board (const board & other) {
+        *this = other;
+    }
+
+    board & operator=(const board & other) {
+        pieces = other.pieces;
+        bitboards = other.bitboards;
+        side_occupancy = other.side_occupancy;
+        occupancy = other.occupancy;
+        history = other.history;
+        state_index = other.state_index;
+        key_filter = other.key_filter;
+        side = other.side;
+        state = &state_at(state_index);
+        return *this;
+    }
+
     void fen_to_board(const std::string& fen) {
         bitboards = {};
         side_occupancy = {};
         occupancy = {};
         std::ranges::fill(pieces, Piece::Null_Piece);
         history = {};
+        key_filter = {};
+        state_index = 0;
         state = &history[0];
         side = Color::White;
         state->hash_key = zobrist();
@@ -78,7 +119,10 @@ public:
         std::string board_str, side_str, castling_str, enpassant_str; //, fifty_move_clock, full_move_number
 
         std::stringstream ss(fen);
-        ss >> board_str >> side_str >> castling_str >> enpassant_str >> state->fifty_move_clock ;//>> full_move_counter;
+        // read as a number, into the uint8_t the clock would be the character code of its first digit
+        int fifty_move_clock = 0;
+        ss >> board_str >> side_str >> castling_str >> enpassant_str >> fifty_move_clock ;//>> full_move_counter;
+        state->fifty_move_clock = static_cast<std::uint8_t>(std::clamp(fifty_move_clock, 0, 100));
 
         int square = Square::A8;
         for (const char fen_char : board_str) {
@@ -91,6 +135,7 @@ public:
                 const auto piece_square = static_cast<Square>(square);
                 bitboards[color][piece] |= bb(piece_square);
                 update_hash(color, piece, piece_square);
+                add_material(color, piece);
                 pieces[square] = piece;
                 square += 1;
             }
@@ -117,12 +162,38 @@ public:
 
         state->enpassant = square_from_string(enpassant_str);
         state->hash_key.update_enpassant_hash(state->enpassant);
+        state->derived = 0;
+    }
+
+    // empty board without castling or en passant for put_piece, much cheaper than a fen as only the current state is reset
+    // the key filter keeps the counts of the old game, which can only make is_draw look further
+    void clear(Color side_to_move) {
+        bitboards = {};
+        side_occupancy = {};
+        occupancy = {};
+        std::ranges::fill(pieces, Piece::Null_Piece);
+        state_index = 0;
+        state = &history[0];
+        *state = {};
+        side = side_to_move;
+        state->hash_key.update_castling_hash(0);
+        state->hash_key.update_enpassant_hash(Null_Square);
+        if (side == Black) {
+            state->hash_key.update_side_hash();
+        }
+    }
 
-        update_bitboards();
+    void put_piece(Color color, Piece piece, Square square) {
+        bitboards[color][piece] |= bb(square);
+        side_occupancy[color] |= bb(square);
+        occupancy |= bb(square);
+        pieces[square] = piece;
+        update_hash(color, piece, square);
+        add_material(color, piece);
     }
 
     template <Color our_color>
-    void calculate_threats() {
+    void calculate_threats() const {
         constexpr Color their_color = our_color == White ? Black : White;
 
         std::uint64_t threatened = pawn_attacks<their_color>(bitboards[their_color][Pawn]);
@@ -150,16 +221,19 @@ public:
 
         threatened |= KING_ATTACKS[lsb(bitboards[their_color][King])];
         state->threats = threatened;
+        state->derived |= THREATS_VALID;
     }
 
     template <Color our_color>
-    void calculate_checkers() {
-        // state->checkers = (state->threats & bitboards[our_color][King]) != 0ull ? attackers<our_color>(lsb(bitboards[our_color][King])) : 0ull;
-        state->checkers = attackers<our_color>(lsb(bitboards[our_color][King]));
+    void calculate_checkers() const {
+        const Square king_square = lsb(bitboards[our_color][King]);
+        state->checkers = attackers<our_color>(king_square);
+        state->checkmask = state->checkers ? pinmask[king_square][lsb(state->checkers)] : 0ull;
+        state->derived |= CHECKERS_VALID;
     }
 
     template <Color our_color>
-    void calculate_pins() {
+    void calculate_pins() const {
         constexpr Color their_color = our_color == White ? Black : White;
         const Square king_square = lsb(bitboards[our_color][King]);
 
@@ -187,25 +261,141 @@ public:
 
         state->pin_diagonal = diagonal_pins;
         state->pin_orthogonal = orthogonal_pins;
+        state->derived |= PINS_VALID;
     }
 
     template <Color our_color>
-    void update_bitboards() {
-        calculate_threats<our_color>();
-        calculate_checkers<our_color>();
-        state->checkmask = 0ull;
-        std::uint64_t checks = checkers();
-        if (checks) {
-            state->checkmask |= pinmask[get_king_square<our_color>()][lsb(checks)];
+    void calculate_check_info() const {
+        constexpr Color their_color = our_color == White ? Black : White;
+        const Square king_square = lsb(bitboards[their_color][King]);
+
+        const std::uint64_t bishop_checks = attacks<Ray::BISHOP>(king_square, occupancy);
+        const std::uint64_t rook_checks = attacks<Ray::ROOK>(king_square, occupancy);
+        state->check_squares = {
+                PAWN_ATTACKS_TABLE[their_color][king_square],
+                KNIGHT_ATTACKS[king_square],
+                bishop_checks,
+                rook_checks,
+                bishop_checks | rook_checks,
+                0ull
+        };
+
+        std::uint64_t blockers = 0ull;
+        std::uint64_t snipers = (attacks<Ray::BISHOP>(king_square, 0ull) & get_diagonal_pieces<our_color>())
+                              | (attacks<Ray::ROOK>(king_square, 0ull) & get_orthogonal_pieces<our_color>());
+        while (snipers) {
+            const Square s = pop_lsb(snipers);
+            const std::uint64_t b = pinmask[king_square][s] & occupancy & ~bb(s);
+
+            if (popcount(b) == 1) {
+                blockers |= b & side_occupancy[our_color];
+            }
+        }
+
+        state->discovered_blockers = blockers;
+        state->derived |= CHECKS_VALID;
+    }
+
+    // Does the move of side to move give check? Answered without making the move.
+    template <Color color>
+    [[nodiscard]] bool gives_check(const chess_move & move) const {
+        constexpr Color their_color = color == White ? Black : White;
+        constexpr Direction pawn_direction = color == White ? NORTH : SOUTH;
+
+        if (!(state->derived & CHECKS_VALID)) {
+            calculate_check_info<color>();
+        }
+
+        const Square from = move.get_from();
+        const Square to = move.get_to();
+        const Square king_square = lsb(bitboards[their_color][King]);
+        std::uint64_t occupied = (occupancy ^ bb(from)) | bb(to);
+
+        // direct check by a piece that stays on its type
+        if (move.get_move_type() != PROMOTION && (state->check_squares[pieces[from]] & bb(to))) {
+            return true;
+        }
+
+        switch (move.get_move_type()) {
+            case NORMAL:
+                break;
+            case PROMOTION:
+                switch (move.get_promotion()) {
+                    case Knight: if (KNIGHT_ATTACKS[to] & bb(king_square)) return true; break;
+                    case Bishop: if (attacks<Ray::BISHOP>(to, occupied) & bb(king_square)) return true; break;
+                    case Rook:   if (attacks<Ray::ROOK>(to, occupied) & bb(king_square)) return true; break;
+                    default:     if (attacks<Ray::QUEEN>(to, occupied) & bb(king_square)) return true; break;
+                }
+                break;
+            case EN_PASSANT:
+                occupied ^= bb(to - pawn_direction);
+                break;
+            case CASTLING: {
+                const CastlingRight cr = to > from ? (color == White ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE)
+                                                   : (color == White ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE);
+                occupied = (occupied ^ bb(CastlingRookFrom[cr])) | bb(CastlingRookTo[cr]);
+                return attacks<Ray::ROOK>(CastlingRookTo[cr], occupied) & bb(king_square);
+            }
+        }
+
+        // discovered check, the en-passant capture may uncover a slider on its own
+        if ((state->discovered_blockers & bb(from)) || move.get_move_type() == EN_PASSANT) {
+            return ((attacks<Ray::BISHOP>(king_square, occupied) & get_diagonal_pieces<color>())
+                    | (attacks<Ray::ROOK>(king_square, occupied) & get_orthogonal_pieces<color>())) & ~bb(from);
         }
+
+        return false;
     }
 
-    void update_bitboards() {
-        side == White ? update_bitboards<White>() : update_bitboards<Black>();
+    // Zobrist key of the position after the move, computed the same way as make_move does
+    template <Color color>
+    [[nodiscard]] std::uint64_t key_after(const chess_move & move) const {
+        constexpr Color their_color = color == White ? Black : White;
+        constexpr Direction pawn_direction = color == White ? NORTH : SOUTH;
+        using namespace zobrist_keys;
+
+        const Square from = move.get_from();
+        const Square to = move.get_to();
+        const Piece piece = pieces[from];
+        const Piece captured = pieces[to];
+
+        std::uint64_t key = state->hash_key.get_key() ^ side_key ^ enpassant_keys[state->enpassant];
+        const std::uint8_t rights = state->castling_rights & castling_mask[from] & (captured != Null_Piece ? castling_mask[to] : 15);
+        key ^= castling_keys[state->castling_rights] ^ castling_keys[rights];
+
+        switch (move.get_move_type()) {
+            case NORMAL:
+                if (captured != Null_Piece) {
+                    key ^= psqt_keys[their_color][captured][to];
+                }
+                key ^= psqt_keys[color][piece][from] ^ psqt_keys[color][piece][to];
+
+                if (piece == Pawn && (int(from) ^ int(to)) == int(NORTH_2)) {
+                    const Square epsq = to - pawn_direction;
+                    if (PAWN_ATTACKS_TABLE[color][epsq] & bitboards[their_color][Pawn]) {
+                        key ^= enpassant_keys[epsq];
+                    }
+                }
+                return key;
+            case PROMOTION:
+                if (captured != Null_Piece) {
+                    key ^= psqt_keys[their_color][captured][to];
+                }
+                return key ^ psqt_keys[color][Pawn][from] ^ psqt_keys[color][move.get_promotion()][to];
+            case EN_PASSANT:
+                return key ^ psqt_keys[their_color][Pawn][to - pawn_direction] ^ psqt_keys[color][Pawn][from] ^ psqt_keys[color][Pawn][to];
+            case CASTLING: {
+                const CastlingRight cr = to > from ? (color == White ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE)
+                                                   : (color == White ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE);
+                return key ^ psqt_keys[color][King][from] ^ psqt_keys[color][King][to]
+                           ^ psqt_keys[color][Rook][CastlingRookFrom[cr]] ^ psqt_keys[color][Rook][CastlingRookTo[cr]];
+            }
+        }
+        return key;
     }
 
     [[nodiscard]] bool in_check() const {
-        return state->checkers;
+        return checkers();
     }
 
     template <Color color>
@@ -265,6 +455,15 @@ public:
         return side_occupancy[side] == (bitboards[side][Pawn] | bitboards[side][King]);
     }
 
+    // older states are overwritten by the ring buffer, only the last hundred plies are ever looked up
+    board_info & state_at(int index) {
+        return history[index % history.size()];
+    }
+
+    [[nodiscard]] const board_info & state_at(int index) const {
+        return history[index % history.size()];
+    }
+
     [[nodiscard]] bool is_draw(int ply) const {
         if (state->fifty_move_clock < 4) {
             return false;
@@ -274,14 +473,17 @@ public:
             return true;
         }
 
-        const int current_index = state - history.data();
-        const int end = std::max(0, current_index - static_cast<int>(state->fifty_move_clock));
+        if (key_filter[state->hash_key.get_key() % key_filter.size()] == 0) {
+            return false;
+        }
+
+        const int end = std::max(0, state_index - static_cast<int>(state->fifty_move_clock));
 
         int repetitions = 0;
 
-        for (int i = current_index - 4; i >= end; i -= 2) {
-            if (history[i].hash_key == state->hash_key) {
-                if (i > current_index - ply) return true;
+        for (int i = state_index - 4; i >= end; i -= 2) {
+            if (state_at(i).hash_key == state->hash_key) {
+                if (i > state_index - ply) return true;
 
                 repetitions++;
                 if (repetitions >= 2) return true;
@@ -291,6 +493,43 @@ public:
         return false;
     }
 
+    // whether the side to move has a reversible move to a position that occurred earlier inside the search,
+    // found through the cuckoo tables without generating moves
+    [[nodiscard]] bool upcoming_repetition(int ply) const {
+        const int end = std::min(static_cast<int>(state->fifty_move_clock), state_index);
+
+        if (end < 3) {
+            return false;
+        }
+
+        const std::uint64_t original_key = state->hash_key.get_key();
+        std::uint64_t other = original_key ^ state_at(state_index - 1).hash_key.get_key() ^ zobrist_keys::side_key;
+
+        for (int i = 3; i <= end && i < ply; i += 2) {
+            other ^= state_at(state_index - i + 1).hash_key.get_key() ^ state_at(state_index - i).hash_key.get_key() ^ zobrist_keys::side_key;
+
+            if (other != 0) {
+                continue;
+            }
+
+            const std::uint64_t move_key = original_key ^ state_at(state_index - i).hash_key.get_key();
+            std::size_t slot = cuckoo::h1(move_key);
+            if (cuckoo::table.keys[slot] != move_key) {
+                slot = cuckoo::h2(move_key);
+                if (cuckoo::table.keys[slot] != move_key) {
+                    continue;
+                }
+            }
+
+            const chess_move move = cuckoo::table.moves[slot];
+            if (!(pinmask[move.get_from()][move.get_to()] & ~bb(move.get_to()) & occupancy)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     void update_castling_rights(Square square) {
         state->hash_key.update_castling_hash(state->castling_rights);
         state->castling_rights &= castling_mask[square];
@@ -303,7 +542,9 @@ public:
         constexpr Color their_color = (color == Black) ? White : Black;
 
         side = their_color;
-        board_info * old_info = state++;
+        key_filter[state->hash_key.get_key() % key_filter.size()]++;
+        board_info * old_info = state;
+        state = &state_at(++state_index);
         state->hash_key = old_info->hash_key;
         state->hash_key.update_side_hash();
         state->hash_key.update_enpassant_hash(old_info->enpassant);
@@ -311,6 +552,9 @@ public:
         state->minor_key = old_info->minor_key;
         state->major_key = old_info->major_key;
         state->nonpawn_key = old_info->nonpawn_key;
+        state->material_key = old_info->material_key;
+        state->piece_counts = old_info->piece_counts;
+        state->phase = old_info->phase;
         state->enpassant = Square::Null_Square;
         state->fifty_move_clock++;
         state->castling_rights = old_info->castling_rights;
@@ -318,14 +562,16 @@ public:
         state->captured_piece = Null_Piece;
         state->move = {};
         state->checkers = 0ull;
-        calculate_threats<their_color>();
+        state->checkmask = 0ull;
+        state->derived = CHECKERS_VALID;
     }
 
     template<Color color>
     void undo_null_move()
     {
         side = color;
-        state--;
+        state = &state_at(--state_index);
+        key_filter[state->hash_key.get_key() % key_filter.size()]--;
     }
 
     [[nodiscard]] std::uint64_t get_hash_key() const {
@@ -349,7 +595,11 @@ public:
     }
 
     [[nodiscard]] chess_move get_last_played_move() const {
-        return history.back().move;
+        return state->move;
+    }
+
+    [[nodiscard]] int get_fifty_move_clock() const {
+        return state->fifty_move_clock;
     }
 
     void reset_fifty_move_clock() {
@@ -366,13 +616,43 @@ public:
     template <Color color>
     [[nodiscard]] std::uint64_t get_diagonal_pieces() const { return bitboards[color][Bishop] | bitboards[color][Queen]; }
 
-    [[nodiscard]] std::uint64_t checkmask() const { return state->checkmask; }
-    [[nodiscard]] std::uint64_t pin_diagonal() const { return state->pin_diagonal; }
-    [[nodiscard]] std::uint64_t pin_orthogonal() const { return state->pin_orthogonal; }
-    [[nodiscard]] std::uint64_t checkers() const { return state->checkers; }
-    [[nodiscard]] std::uint64_t checked_squares() const { return state->threats; }
+    [[nodiscard]] std::uint64_t checkmask() const {
+        if (!(state->derived & CHECKERS_VALID)) {
+            side == White ? calculate_checkers<White>() : calculate_checkers<Black>();
+        }
+        return state->checkmask;
+    }
+
+    [[nodiscard]] std::uint64_t pin_diagonal() const {
+        if (!(state->derived & PINS_VALID)) {
+            side == White ? calculate_pins<White>() : calculate_pins<Black>();
+        }
+        return state->pin_diagonal;
+    }
+
+    [[nodiscard]] std::uint64_t pin_orthogonal() const {
+        if (!(state->derived & PINS_VALID)) {
+            side == White ? calculate_pins<White>() : calculate_pins<Black>();
+        }
+        return state->pin_orthogonal;
+    }
+
+    [[nodiscard]] std::uint64_t checkers() const {
+        if (!(state->derived & CHECKERS_VALID)) {
+            side == White ? calculate_checkers<White>() : calculate_checkers<Black>();
+        }
+        return state->checkers;
+    }
+
+    [[nodiscard]] std::uint64_t checked_squares() const {
+        if (!(state->derived & THREATS_VALID)) {
+            side == White ? calculate_threats<White>() : calculate_threats<Black>();
+        }
+        return state->threats;
+    }
 
     [[nodiscard]] bool can_castle(CastlingRight cr) const { return state->castling_rights & cr; }
+    [[nodiscard]] bool has_castling_rights() const { return state->castling_rights; }
 
     template<Color Me> void set_piece(Piece p, Square sq){
         std::uint64_t b = bb(sq);
@@ -405,13 +685,16 @@ public:
 
     template <Color color>
     void undo_state() {
-        state--;
+        state = &state_at(--state_index);
+        key_filter[state->hash_key.get_key() % key_filter.size()]--;
         side = color;
     }
 
     template <Color color>
     void make_state(Piece captured_piece, chess_move played_move) {
-        board_info * old_state = state++;
+        key_filter[state->hash_key.get_key() % key_filter.size()]++;
+        board_info * old_state = state;
+        state = &state_at(++state_index);
         state->hash_key = old_state->hash_key;
         state->hash_key.update_enpassant_hash(old_state->enpassant);
         state->hash_key.update_side_hash();
@@ -419,11 +702,15 @@ public:
         state->major_key = old_state->major_key;
         state->minor_key = old_state->minor_key;
         state->nonpawn_key = old_state->nonpawn_key;
+        state->material_key = old_state->material_key;
+        state->piece_counts = old_state->piece_counts;
+        state->phase = old_state->phase;
         state->enpassant = Null_Square;
         state->castling_rights = old_state->castling_rights;
         state->fifty_move_clock = old_state->fifty_move_clock + 1;
         state->captured_piece = captured_piece;
         state->move = played_move;
+        state->derived = 0;
         side = color;
     }
 
@@ -455,48 +742,35 @@ public:
         return pieces[move.get_to()] != Null_Piece;
     }
 
-    void shift_history() {
-        const int index = state - history.data();
-        for (int i = 100; i <= index; ++i) {
-            history[i - 100] = history[i];
-        }
-
-        board_info default_value = {}; // Default constructed board_info
-        std::fill(history.begin() + (index - 100 + 1), history.begin() + (index + 1), default_value);
+    std::uint64_t get_threats() const {
+        return checked_squares();
+    }
 
-        state -= 100;
+    int move_count() {
+        return (state_index + 1) / 2;
     }
 
-    std::uint64_t get_threats() const {
-        return state->threats;
+    // material is tracked by make_move, moves that keep the material only copy it with the state
+    void add_material(Color color, Piece piece) {
+        state->material_key.update_psqt_hash(color, piece, static_cast<Square>(state->piece_counts[color][piece]++));
+        state->phase += phase_values[piece];
     }
 
-    int move_count() {
-        const int current_index = state - history.data();
-        return (current_index + 1) / 2;
-    }
-
-    std::uint64_t get_material_key() const {
-        auto murmur_hash_3 = [](std::uint64_t key) -> std::uint64_t {
-            key ^= key >> 33;
-            key *= 0xff51afd7ed558ccd;
-            key ^= key >> 33;
-            key *= 0xc4ceb9fe1a85ec53;
-            key ^= key >> 33;
-            return key;
-        };
+    void remove_material(Color color, Piece piece) {
+        state->material_key.update_psqt_hash(color, piece, static_cast<Square>(--state->piece_counts[color][piece]));
+        state->phase -= phase_values[piece];
+    }
 
-        std::uint64_t material_key = 0;
+    [[nodiscard]] std::uint64_t get_material_key() const {
+        return state->material_key.get_key();
+    }
 
-        for (Color c : {Color::White, Color::Black}) {
-            for (Piece p : {Pawn, Knight, Bishop, Rook, Queen}) {
-                int shift = p * 6 + c * 30;
-                std::uint64_t count = std::popcount(this->bitboards[c][p]);
-                material_key |= (count << shift);
-            }
-        }
+    [[nodiscard]] int piece_count(Color color, Piece piece) const {
+        return state->piece_counts[color][piece];
+    }
 
-        return murmur_hash_3(material_key);
+    [[nodiscard]] int get_phase() const {
+        return state->phase;
     }
 };
 
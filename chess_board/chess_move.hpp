@@ -88,4 +88,37 @@ private:
     std::uint16_t packed_move_data = 0;
 };
 
+// chess_move annotated by the move generator with the moving piece and the piece on the target square,
+// the 16-bit chess_move base is what gets stored in the transposition table
+class extended_move : public chess_move {
+public:
+    constexpr extended_move() = default;
+
+    constexpr extended_move(Square from, Square to, MoveType move_type, Piece piece, Piece captured, PromotionType pt = KnightPromotion)
+            : chess_move(from, to, move_type, pt), piece(piece), captured(captured) {}
+
+    [[nodiscard]] Piece get_piece() const {
+        return piece;
+    }
+
+    // piece standing on the target square, Null_Piece for en passant
+    [[nodiscard]] Piece get_captured() const {
+        return captured;
+    }
+
+    [[nodiscard]] bool is_capture() const {
+        return captured != Null_Piece;
+    }
+
+    [[nodiscard]] bool is_quiet() const {
+        return get_move_type() != PROMOTION && get_move_type() != EN_PASSANT && captured == Null_Piece;
+    }
+
+private:
+    Piece piece = Null_Piece;
+    Piece captured = Null_Piece;
+};
+
+static_assert(sizeof(extended_move) == 4);
+
 #endif //MOTOR_CHESS_MOVE_HPP
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef MOTOR_CUCKOO_HPP
+#define MOTOR_CUCKOO_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "types.hpp"
+#include "chess_move.hpp"
+#include "zobrist_keys.hpp"
+
+// Cuckoo tables of the hash differences of all reversible piece moves (Marcel van Kervinck's method),
+// used to find a move that repeats an earlier position of the game
+namespace cuckoo {
+
+    constexpr std::size_t table_size = 8192;
+
+    constexpr std::size_t h1(std::uint64_t key) {
+        return key & (table_size - 1);
+    }
+
+    constexpr std::size_t h2(std::uint64_t key) {
+        return (key >> 16) & (table_size - 1);
+    }
+
+    struct tables {
+        std::array<std::uint64_t, table_size> keys;
+        std::array<chess_move, table_size> moves;
+    };
+
+    // whether the piece moves between the two squares on an empty board
+    constexpr bool reaches(Piece piece, int first, int second) {
+        const int file_distance = first % 8 > second % 8 ? first % 8 - second % 8 : second % 8 - first % 8;
+        const int rank_distance = first / 8 > second / 8 ? first / 8 - second / 8 : second / 8 - first / 8;
+
+        const bool diagonal = file_distance == rank_distance;
+        const bool orthogonal = file_distance == 0 || rank_distance == 0;
+
+        switch (piece) {
+            case Knight: return file_distance * rank_distance == 2;
+            case Bishop: return diagonal;
+            case Rook:   return orthogonal;
+            case Queen:  return diagonal || orthogonal;
+            case King:   return std::max(file_distance, rank_distance) == 1;
+            default:     return false;
+        }
+    }
+
+    constexpr tables generate() {
+        tables table{};
+
+        for (const Color color : {White, Black}) {
+            for (const Piece piece : {Knight, Bishop, Rook, Queen, King}) {
+                for (int first = 0; first < 64; first++) {
+                    for (int second = first + 1; second < 64; second++) {
+                        if (!reaches(piece, first, second)) {
+                            continue;
+                        }
+
+                        chess_move move(static_cast<Square>(first), static_cast<Square>(second), NORMAL);
+                        std::uint64_t key = zobrist_keys::psqt_keys[color][piece][first]
+                                          ^ zobrist_keys::psqt_keys[color][piece][second]
+                                          ^ zobrist_keys::side_key;
+
+                        // insert, moving the displaced entry to its other slot until an empty one is found
+                        std::size_t slot = h1(key);
+                        while (true) {
+                            std::swap(table.keys[slot], key);
+                            std::swap(table.moves[slot], move);
+                            if (key == 0) {
+                                break;
+                            }
+                            slot = slot == h1(key) ? h2(key) : h1(key);
+                        }
+                    }
+                }
+            }
+        }
+
+        return table;
+    }
+
+    constexpr tables table = generate();
+}
+
+#endif //MOTOR_CUCKOO_HPP
@@ -51,7 +51,7 @@ namespace zobrist_keys {
             0x625bfd47d1efb0d7ull, 0xbcba1ad014a8d134ull, 0xc54379628fd3f70full, 0x622054d776e8e8d8ull,
     };
 
-    std::uint64_t side_key = 0x164a88c2eb4a2489ull;
+    constexpr std::uint64_t side_key = 0x164a88c2eb4a2489ull;
 
 }
 
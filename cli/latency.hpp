@@ -0,0 +1,139 @@
+#ifndef MOTOR_LATENCY_HPP
+#define MOTOR_LATENCY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "uci.hpp"
+
+// Takes the place of the buffer of std::cout during a search and notes when the first info line and the bestmove line
+// are complete. The lines themselves are dropped.
+class latency_probe : public std::streambuf {
+public:
+    using clock = std::chrono::steady_clock;
+
+    void start() {
+        line.clear();
+        first_info = bestmove = {};
+        seen_info = seen_bestmove = false;
+    }
+
+    bool seen_info = false;
+    bool seen_bestmove = false;
+    clock::time_point first_info;
+    clock::time_point bestmove;
+
+protected:
+    int overflow(int c) override {
+        if (c == '\n') {
+            if (!seen_info && line.starts_with("info")) {
+                first_info = clock::now();
+                seen_info = true;
+            } else if (!seen_bestmove && line.starts_with("bestmove")) {
+                bestmove = clock::now();
+                seen_bestmove = true;
+            }
+            line.clear();
+        } else if (c != traits_type::eof()) {
+            line += static_cast<char>(c);
+        }
+        return c;
+    }
+
+private:
+    std::string line;
+};
+
+struct latency_setting {
+    std::string go;
+    int movetime = -1;
+    int time = -1;
+    int increment = 0;
+};
+
+// p50, p99 and max of the milliseconds
+std::string latency_distribution(std::vector<double> values) {
+    if (values.empty()) {
+        return "no samples";
+    }
+
+    std::ranges::sort(values);
+    std::stringstream line;
+    line << std::fixed << std::setprecision(2)
+         << "p50 " << values[values.size() / 2]
+         << " p99 " << values[std::min(values.size() - 1, values.size() * 99 / 100)]
+         << " max " << values.back();
+    return line.str();
+}
+
+// Runs go commands with a time limit on the bench positions and reports, in milliseconds, the time from go to the first
+// info line, from the deadline to bestmove and the overshoot of the time the GUI gave. The deadline is the hard limit of
+// the time manager, so a search that ends on its soft limit has a negative value. With the clock the time the GUI gave
+// is the deadline plus the Move Overhead. Writing to the pipe and the GUI are not part of the numbers.
+void latency(int positions) {
+    const std::vector<latency_setting> settings = {
+        {"movetime 50", 50},
+        {"movetime 100", 100},
+        {"movetime 250", 250},
+        {"wtime 1000 btime 1000 winc 10 binc 10", -1, 1000, 10},
+        {"wtime 3000 btime 3000 winc 30 binc 30", -1, 3000, 30},
+    };
+
+    positions = std::clamp(positions, 1, static_cast<int>(std::size(fens)));
+    latency_probe probe;
+    board chessboard;
+
+    history->clear();
+    tt.clear();
+    root_moves.clear();
+
+    for (const latency_setting & setting : settings) {
+        std::vector<double> first_info, deadline, overshoot;
+
+        for (int i = 0; i < positions; i++) {
+            chessboard.fen_to_board(fens[i]);
+            set_position(chessboard);
+            last_position = {};
+
+            int limit;
+            if (setting.movetime != -1) {
+                limit = std::max(1, setting.movetime - move_overhead);
+            } else {
+                time_keeper keeper;
+                keeper.reset(setting.time, setting.increment, 0, chessboard.move_count());
+                limit = keeper.hard_limit();
+            }
+
+            probe.start();
+            std::streambuf * const console = std::cout.rdbuf(&probe);
+            const auto go = latency_probe::clock::now();
+            uci_go(chessboard, setting.go);
+            std::cout.rdbuf(console);
+
+            auto milliseconds = [&](latency_probe::clock::time_point point) {
+                return std::chrono::duration<double, std::milli>(point - go).count();
+            };
+
+            if (probe.seen_info) {
+                first_info.push_back(milliseconds(probe.first_info));
+            }
+            if (probe.seen_bestmove) {
+                deadline.push_back(milliseconds(probe.bestmove) - limit);
+                overshoot.push_back(milliseconds(probe.bestmove) - (setting.movetime != -1 ? setting.movetime : limit + move_overhead));
+            }
+        }
+
+        std::cout << "go " << setting.go << "\n"
+                  << "  go to first info      " << latency_distribution(first_info) << "\n"
+                  << "  deadline to bestmove  " << latency_distribution(deadline) << "\n"
+                  << "  overshoot             " << latency_distribution(overshoot) << std::endl;
+    }
+}
+
+#endif //MOTOR_LATENCY_HPP
@@ -12,11 +12,15 @@
 #include "../executioner/makemove.hpp"
 #include "../search/time_keeper.hpp"
 #include "../search/search.hpp"
+#include "../search/mate_search.hpp"
 #include "../search/bench.hpp"
 #include "../perft.hpp"
+#include "../tablebase/generator.hpp"
 
 std::vector<TuningOption*> tuning_options = {};
 
+unsigned int mate_threads = 1;
+
 void print_tune_options() {
     std::cout << "name,type,default,min,max,step,0.002" << std::endl;
     for (const auto& option : tuning_options) {
@@ -28,8 +32,17 @@ void print_tune_options() {
     }
 }
 
+// moves of the last position command, a command that extends them plays only the new moves
+struct position_record {
+    std::string base;
+    std::vector<std::string> moves;
+};
+
+position_record last_position;
+
+// plays the move on the board and the accumulators, which are kept at the bottom of the accumulator stack
 bool parse_move(board & b, const std::string& move_string) {
-    move_list ml;
+    stack_move_list ml;
     if (b.get_side() == White) {
         generate_all_moves<White, false>(b, ml);
     } else {
@@ -39,10 +52,11 @@ bool parse_move(board & b, const std::string& move_string) {
     for (const chess_move & m : ml) {
         if (m.to_string() == move_string) {
             if (b.get_side() == White) {
-                make_move<White, false>(b, m);
+                make_move<White>(b, m);
             } else {
-                make_move<Black, false>(b, m);
+                make_move<Black>(b, m);
             }
+            network.rebase();
             return true;
         }
     }
@@ -50,41 +64,44 @@ bool parse_move(board & b, const std::string& move_string) {
 }
 
 void position_uci(board & b, const std::string & command) {
-    // Initialize from FEN string
     auto fen_pos = command.find("fen");
     auto moves_pos = command.find("moves");
 
-    if (command.find("startpos") != std::string::npos) {
-        b.fen_to_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
-    } else if (command.find("fen") != std::string::npos) {
-        std::string fen = command.substr(fen_pos + 3, moves_pos);
-        b.fen_to_board(fen);
+    std::vector<std::string> moves;
+    if (moves_pos != std::string::npos) {
+        std::stringstream move_ss(command.substr(moves_pos + 5));
+        std::string string_move;
+        while (move_ss >> string_move) {
+            moves.push_back(string_move);
+        }
     }
 
-    if (moves_pos == std::string::npos) {
+    // the board is still at the end of the last command, search undoes all of its moves
+    const std::string base = command.substr(0, moves_pos);
+    std::size_t played = last_position.moves.size();
+    const bool extends = base == last_position.base && moves.size() >= played
+                         && std::equal(last_position.moves.begin(), last_position.moves.end(), moves.begin());
+
+    if (!extends) {
+        if (command.find("startpos") != std::string::npos) {
+            b.fen_to_board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        } else if (fen_pos != std::string::npos) {
+            std::string fen = command.substr(fen_pos + 3, moves_pos);
+            b.fen_to_board(fen);
+        }
         set_position(b);
-        return;
+        played = 0;
     }
 
-    std::stringstream move_ss(command.substr(moves_pos + 5));
-    std::vector<std::string> moves;
-    std::string string_move;
-
-    while (move_ss >> string_move) {
-        moves.push_back(string_move);
-    }
+    last_position.base = base;
+    last_position.moves.assign(moves.begin(), moves.begin() + played);
 
-    int i = 0;
-    for (const std::string & m : moves) {
-        if (!parse_move(b, m)) return;
-        i++;
-        if (i > 200) {
-            b.shift_history();
-            i -= 100;
+    for (; played < moves.size(); played++) {
+        if (!parse_move(b, moves[played])) {
+            return;
         }
+        last_position.moves.push_back(moves[played]);
     }
-
-    set_position(b);
 }
 
 void uci_go(board& b, const std::string& command) {
@@ -111,12 +128,22 @@ void uci_go(board& b, const std::string& command) {
         } else if (tokens[i] == "depth") {
             info.max_depth = std::stoi(tokens[i + 1]); 
         } else if (tokens[i] == "movetime") {
-            info.wtime = info.btime = 10 * std::max(10, std::stoi(tokens[i + 1]));
+            info.movetime = std::max(1, std::stoi(tokens[i + 1]));
         } else if (tokens[i] == "infinite") {
             // info.infinite = true;                      
         } else if (tokens[i] == "nodes") {
             info.max_nodes = std::stoi(tokens[i + 1]);
+        } else if (tokens[i] == "mate") {
+            info.mate = std::stoi(tokens[i + 1]);
+        }
+    }
+
+    if (info.mate > 0) {
+        if (mate_finder.run(b, info.mate, mate_threads, info.max_nodes)) {
+            return;
         }
+        // without a mate the move comes from the regular search, which needs about two plies per move of the mate
+        info.max_depth = std::min(info.max_depth, 2 * info.mate + 1);
     }
 
     find_best_move(b, info);
@@ -141,6 +168,12 @@ void uci_process(board& b, const std::string& line) {
         std::cout << "id author Martin Novak " << std::endl;    
         std::cout << "option name Hash type spin default " << 32 << " min 1 max 1024" << std::endl;
         std::cout << "option name Threads type spin default 1 min 1 max 1" << std::endl;
+        std::cout << "option name TablebasePath type string default <empty>" << std::endl;
+        std::cout << "option name Move Overhead type spin default 50 min 0 max 5000" << std::endl;
+        std::cout << "option name MateThreads type spin default 1 min 1 max 256" << std::endl;
+        std::cout << "option name OwnBook type check default false" << std::endl;
+        std::cout << "option name BookFile type string default <empty>" << std::endl;
+        std::cout << "option name BookBestMove type check default false" << std::endl;
 
         auto print_option = [](const TuningOption* option) {
             std::cout << "option name " << option->name
@@ -157,6 +190,8 @@ void uci_process(board& b, const std::string& line) {
     } else if (command == "ucinewgame") {
         history->clear();
         tt.clear();
+        last_position = {};
+        root_moves.clear();
     } else if (command == "setoption") {
         std::string token;
         std::vector<std::string> tokens;
@@ -165,9 +200,29 @@ void uci_process(board& b, const std::string& line) {
             tokens.push_back(token);
         }
 
-        if (tokens.size() >= 4) {
+        if (tokens.size() >= 5 && tokens[1] == "Move" && tokens[2] == "Overhead") {
+            move_overhead = std::clamp(std::stoi(tokens[4]), 0, 5000);
+        } else if (tokens.size() >= 4) {
             if (tokens[1] == "Hash" || tokens[1] == "hash") {
                 tt.resize(std::stoi(tokens[3]) * 1024 * 1024);
+            } else if (tokens[1] == "OwnBook") {
+                book.set_own_book(tokens[3] == "true");
+            } else if (tokens[1] == "BookBestMove") {
+                book.set_best_move(tokens[3] == "true");
+            } else if (tokens[1] == "BookFile") {
+                std::string path = tokens[3];
+                for (std::size_t i = 4; i < tokens.size(); i++) {
+                    path += " " + tokens[i];
+                }
+                std::cout << "info string " << (book.load(path) ? "loaded book " : "could not load book ") << path << std::endl;
+            } else if (tokens[1] == "MateThreads") {
+                mate_threads = std::clamp(std::stoi(tokens[3]), 1, 256);
+            } else if (tokens[1] == "TablebasePath") {
+                std::string path = tokens[3];
+                for (std::size_t i = 4; i < tokens.size(); i++) {
+                    path += " " + tokens[i];
+                }
+                std::cout << "info string " << tablebases.load(path) << " tablebases loaded" << std::endl;
             }
         } else {
             auto it = std::find_if(tuning_options.begin(), tuning_options.end(),
@@ -182,10 +237,24 @@ void uci_process(board& b, const std::string& line) {
                 std::cout << "Option not found." << std::endl;
             }
         }
+    } else if (command == "stats") {
+#ifdef MOTOR_STATS
+        last_search_stats.print();
+#else
+        std::cout << "info string search statistics need a build with MOTOR_STATS" << std::endl;
+#endif
     } else if (command == "bench") {
-        history->clear();
-        tt.clear();
-        bench(13);
+        std::vector<std::string> tokens;
+        for (std::string token; ss >> token;) {
+            tokens.push_back(token);
+        }
+        bench(parse_bench_options(tokens));
+        last_position = {}; // bench reuses the accumulators
+    } else if (command == "profile") {
+        int depth = 13;
+        ss >> depth;
+        profile(depth);
+        last_position = {};
     } else if (command == "perft") {
         ss >> command;
         perft_debug(b, std::stoi(command));
@@ -0,0 +1,147 @@
+#ifndef MOTOR_ENDGAME_HPP
+#define MOTOR_ENDGAME_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../chess_board/board.hpp"
+
+constexpr std::uint64_t DARK_SQUARES = 0xaa55aa55aa55aa55ull;
+
+// non-pawn material used by the scaling rules
+constexpr std::array<int, 6> endgame_values = {0, 300, 320, 500, 900, 0};
+
+// full evaluation, scale factors are out of it
+constexpr int NORMAL_SCALE = 64;
+
+enum class EndgameKind : std::uint8_t {
+    None,
+    Draw,    // no mate is possible with the material left, search scores the position as a draw
+    Bishops, // one bishop each and no other pieces, scaled further when the bishops are of opposite colours
+};
+
+// What is known about one material configuration, computed once per material key
+struct material_entry {
+    std::uint64_t key = 0;
+    std::array<std::uint8_t, 2> scale = {NORMAL_SCALE, NORMAL_SCALE}; // applied when the side is ahead
+    EndgameKind kind = EndgameKind::None;
+
+    [[nodiscard]] bool is_draw() const {
+        return kind == EndgameKind::Draw;
+    }
+
+    [[nodiscard]] int scale_factor(const board & chessboard, Color strong_side) const {
+        int factor = scale[strong_side];
+
+        if (kind == EndgameKind::Bishops) {
+            const bool white_dark = chessboard.get_pieces(White, Bishop) & DARK_SQUARES;
+            const bool black_dark = chessboard.get_pieces(Black, Bishop) & DARK_SQUARES;
+            if (white_dark != black_dark) {
+                factor = std::min(factor, NORMAL_SCALE / 2);
+            }
+        }
+
+        return factor;
+    }
+};
+
+class material_table {
+public:
+    material_table() : entries(table_size) {}
+
+    const material_entry & probe(const board & chessboard) {
+        const std::uint64_t key = chessboard.get_material_key();
+        material_entry & entry = entries[key % table_size];
+
+        if (entry.key != key) {
+            entry = recognise(chessboard);
+            entry.key = key;
+        }
+
+        return entry;
+    }
+
+private:
+    static constexpr std::size_t table_size = 8192;
+    std::vector<material_entry> entries;
+
+    static int non_pawn_material(const board & chessboard, Color side) {
+        int material = 0;
+        for (const Piece piece : {Knight, Bishop, Rook, Queen}) {
+            material += endgame_values[piece] * chessboard.piece_count(side, piece);
+        }
+        return material;
+    }
+
+    // Bare kings or a single minor piece on the board, no sequence of moves ends in mate. Material that only can not
+    // force mate, such as a minor against a minor, is left to the scale factors because mates still exist there.
+    static bool dead_material(const board & chessboard) {
+        int minors = 0;
+        for (const Color side : {White, Black}) {
+            if (chessboard.piece_count(side, Pawn) || chessboard.piece_count(side, Rook) || chessboard.piece_count(side, Queen)) {
+                return false;
+            }
+            minors += chessboard.piece_count(side, Knight) + chessboard.piece_count(side, Bishop);
+        }
+        return minors <= 1;
+    }
+
+    // a lone minor piece, or two knights against a bare king, can not force mate
+    static bool cannot_win(const board & chessboard, Color side) {
+        const Color enemy = side == White ? Black : White;
+        if (chessboard.piece_count(side, Pawn) || chessboard.piece_count(side, Rook) || chessboard.piece_count(side, Queen)) {
+            return false;
+        }
+
+        const int knights = chessboard.piece_count(side, Knight);
+        const int bishops = chessboard.piece_count(side, Bishop);
+        const bool bare_enemy = chessboard.piece_count(enemy, Pawn) == 0 && non_pawn_material(chessboard, enemy) == 0;
+
+        return knights + bishops <= 1 || (knights == 2 && bishops == 0 && bare_enemy);
+    }
+
+    static material_entry recognise(const board & chessboard) {
+        material_entry entry;
+
+        if (dead_material(chessboard)) {
+            entry.kind = EndgameKind::Draw;
+            entry.scale = {0, 0};
+            return entry;
+        }
+
+        for (const Color side : {White, Black}) {
+            const Color enemy = side == White ? Black : White;
+            const int strong_material = non_pawn_material(chessboard, side);
+            const int weak_material = non_pawn_material(chessboard, enemy);
+
+            if (cannot_win(chessboard, side)) {
+                entry.scale[side] = 0;
+            } else if (!chessboard.piece_count(side, Pawn) && strong_material - weak_material <= endgame_values[Bishop]) {
+                // without pawns an advantage of at most a minor piece is hard to convert
+                entry.scale[side] = strong_material < endgame_values[Rook] ? 0 : weak_material <= endgame_values[Bishop] ? 4 : 14;
+            }
+        }
+
+        const bool only_bishops = [&] {
+            for (const Color side : {White, Black}) {
+                if (chessboard.piece_count(side, Bishop) != 1 || chessboard.piece_count(side, Knight)
+                    || chessboard.piece_count(side, Rook) || chessboard.piece_count(side, Queen)) {
+                    return false;
+                }
+            }
+            return true;
+        }();
+
+        if (only_bishops) {
+            entry.kind = EndgameKind::Bishops;
+        }
+
+        return entry;
+    }
+};
+
+material_table material_cache;
+
+#endif //MOTOR_ENDGAME_HPP
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include "incbin.hpp"
+#include "../profiler.hpp"
 
 #include <immintrin.h>
 
@@ -76,6 +77,7 @@ public:
     }
 
     void push() {
+        PROFILE_SECTION(Accumulator);
         white_accumulator_stack[index + 1] = white_accumulator_stack[index];
         black_accumulator_stack[index + 1] = black_accumulator_stack[index];
         index++;
@@ -85,12 +87,20 @@ public:
         index--;
     }
 
-    int get_square_index(int square, int king_square) {
+    // moves the current accumulators to the bottom of the stack, used after playing the moves of the game
+    void rebase() {
+        white_accumulator_stack[0] = white_accumulator_stack[index];
+        black_accumulator_stack[0] = black_accumulator_stack[index];
+        index = 0;
+    }
+
+    [[nodiscard]] int get_square_index(int square, int king_square) const {
         return (king_square % 8 > 3) ? square ^ 7 : square;
     }
 
     template<Operation operation, Color perspective>
     void update_accumulator(const Piece piece, const Color color, const Square square, int king) {
+        PROFILE_SECTION(Accumulator);
         if constexpr (perspective == White) {
             const auto& white_weights = weights.feature_weight[buckets[king] % Cells][color][piece][get_square_index(square, king)];
             auto& white_accumulator = white_accumulator_stack[index];
@@ -124,6 +134,7 @@ public:
 
     template<Operation operation>
     void update_accumulator(const Piece piece, const Color color, const Square square, int wking, int bking) {
+        PROFILE_SECTION(Accumulator);
         const auto& white_weights = weights.feature_weight[buckets[wking] % Cells][color][piece][get_square_index(square, wking)];
         const auto& black_weights = weights.feature_weight[buckets[bking ^ 56] % Cells][color ^ 1][piece][get_square_index(square, bking) ^ 56];
 
@@ -144,9 +155,23 @@ public:
         }
     }
 
+    // touches the first cache lines of both weight rows of a feature, the hardware prefetcher streams the rest
+    void prefetch(const Piece piece, const Color color, const Square square, int wking, int bking) const {
+        constexpr std::size_t lines = 4;
+        constexpr std::size_t line_entries = 64 / sizeof(std::int16_t);
+        const auto& white_weights = weights.feature_weight[buckets[wking] % Cells][color][piece][get_square_index(square, wking)];
+        const auto& black_weights = weights.feature_weight[buckets[bking ^ 56] % Cells][color ^ 1][piece][get_square_index(square, bking) ^ 56];
+
+        for (std::size_t line = 0; line < lines; line++) {
+            __builtin_prefetch(white_weights.data() + line * line_entries);
+            __builtin_prefetch(black_weights.data() + line * line_entries);
+        }
+    }
+
 #ifndef __AVX2__
     template <Color color>
     std::int32_t evaluate() {
+        PROFILE_SECTION(Evaluate);
         std::int32_t sum = 0;
 
         const auto& stm_accumulator = color == White ? white_accumulator_stack[index] : black_accumulator_stack[index];
@@ -162,6 +187,7 @@ public:
 #else
     template <Color color>
     std::int32_t evaluate() {
+        PROFILE_SECTION(Evaluate);
         const auto& stm_accumulator = color == White ? white_accumulator_stack[index] : black_accumulator_stack[index];
         const auto& nstm_accumulator = color == White ? black_accumulator_stack[index] : white_accumulator_stack[index];
 
@@ -3,18 +3,17 @@
 
 #include "../chess_board/board.hpp"
 #include "../evaluation/nnue.hpp"
+#include "../evaluation/endgame.hpp"
+#include "../profiler.hpp"
 
 template <Color color>
 std::int16_t evaluate(board& chessboard) {
-    int game_phase =
-            (popcount(chessboard.get_pieces(White, Knight) + chessboard.get_pieces(Black, Knight))) +
-            (popcount(chessboard.get_pieces(White, Bishop) + chessboard.get_pieces(Black, Bishop))) +
-            (popcount(chessboard.get_pieces(White, Rook) + chessboard.get_pieces(Black, Rook))) * 2 +
-            (popcount(chessboard.get_pieces(White, Queen) + chessboard.get_pieces(Black, Queen))) * 4;
+    constexpr Color enemy_color = color == White ? Black : White;
+    int material = std::min(chessboard.get_phase(), 24);
 
-    int material = std::min(game_phase, 24);
-
-    return network.evaluate<color>() * (56 + material) / 64;
+    const int eval = network.evaluate<color>() * (56 + material) / 64;
+    const material_entry & entry = material_cache.probe(chessboard);
+    return eval * entry.scale_factor(chessboard, eval > 0 ? color : enemy_color) / NORMAL_SCALE;
 }
 
 void set_position(board& chessboard) {
@@ -36,6 +35,7 @@ void set_position(board& chessboard) {
 
 template<Color color>
 void update_bucket(board& chessboard, int king) {
+    PROFILE_SECTION(Accumulator);
     network.refresh_current_accumulator<color>();
 
     for (Color side : {White, Black}) {
@@ -53,6 +53,7 @@ void update_bucket(board& chessboard, int king) {
 template<Color side, bool update_nnue>
 void unset_piece(board & b, Piece piece, Square to, int wking, int bking) {
     b.unset_piece<side>(piece, to);
+    b.remove_material(side, piece);
 
     if constexpr (update_nnue) {
         network.update_accumulator<Operation::Unset>(piece, side, to, wking, bking);
@@ -62,6 +63,7 @@ void unset_piece(board & b, Piece piece, Square to, int wking, int bking) {
 template<Color side, bool update_nnue>
 void set_piece(board & b, Piece piece, Square to, int wking, int bking) {
     b.set_piece<side>(piece, to);
+    b.add_material(side, piece);
 
     if constexpr (update_nnue) {
         network.update_accumulator<Operation::Set>(piece, side, to, wking, bking);
@@ -78,8 +80,33 @@ void move_piece(board & b, Piece piece, Square from, Square to, int wking, int b
     }
 }
 
+// prefetches the weight rows make_move will add and subtract, king moves and castling are left out
+template<Color side>
+void prefetch_move(const board & b, const extended_move & m) {
+    constexpr Color their_side = side == White ? Black : White;
+    const Piece piece = m.get_piece();
+    if (piece == King) {
+        return;
+    }
+
+    const int wking = lsb(b.get_pieces(White, King));
+    const int bking = lsb(b.get_pieces(Black, King));
+    const Square from = m.get_from();
+    const Square to = m.get_to();
+
+    network.prefetch(piece, side, from, wking, bking);
+    network.prefetch(m.get_move_type() == PROMOTION ? m.get_promotion() : piece, side, to, wking, bking);
+
+    if (m.get_move_type() == EN_PASSANT) {
+        network.prefetch(Pawn, their_side, side == White ? to - NORTH : to - SOUTH, wking, bking);
+    } else if (m.get_captured() != Null_Piece) {
+        network.prefetch(m.get_captured(), their_side, to, wking, bking);
+    }
+}
+
 template<Color side, bool update_nnue = true>
 void make_move(board & b, chess_move m) {
+    PROFILE_SECTION(Make_Move);
     constexpr Color their_side = side == White ? Black : White;
     constexpr Direction PawnDirection = side == White ? NORTH : SOUTH;
     const Square from = m.get_from();
@@ -176,12 +203,11 @@ void make_move(board & b, chess_move m) {
             break;
         }
     }
-
-    b.update_bitboards<their_side>();
 }
 
 template<Color side, bool update_nnue = true>
 void undo_move(board & b, chess_move m) {
+    PROFILE_SECTION(Make_Move);
     constexpr Color their_side = side == White ? Black : White;
     const Square from = m.get_from();
     const Square to = m.get_to();
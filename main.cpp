@@ -1,8 +1,39 @@
 #include "cli/uci.hpp"
+#include "cli/latency.hpp"
 
 int main (int argv, char* argc[]) {
+    // bench [depth] [threads] [hashMB] [fenfile|default] [runs] [json] [perf]
     if (argv > 1 && std::string{ argc[1] } == "bench") {
-        bench(13);
+        bench(parse_bench_options(std::vector<std::string>(argc + 2, argc + argv)));
+        return 0;
+    }
+
+    // profile [depth], bench with the cycles of the hot sections per node, needs a build with MOTOR_PROFILE
+    if (argv > 1 && std::string{ argc[1] } == "profile") {
+        profile(argv > 2 ? std::stoi(argc[2]) : 13);
+        return 0;
+    }
+
+    // latency [positions], go to info and deadline to bestmove times of searches with a time limit
+    if (argv > 1 && std::string{ argc[1] } == "latency") {
+        latency(argv > 2 ? std::stoi(argc[2]) : 50);
+        return 0;
+    }
+
+    // makebook <games> <book> [plies], games are lines of moves from the start position
+    if (argv > 3 && std::string{ argc[1] } == "makebook") {
+        const int plies = argv > 4 ? std::stoi(argc[4]) : 20;
+        std::cout << (make_book(argc[2], argc[3], plies) ? "book written" : "could not build the book") << std::endl;
+        return 0;
+    }
+
+    // tbgen <directory> [threads] [wdl|dtm] [men]
+    if (argv > 1 && std::string{ argc[1] } == "tbgen") {
+        const std::string directory = argv > 2 ? argc[2] : ".";
+        const unsigned int threads = argv > 3 ? std::stoi(argc[3]) : std::thread::hardware_concurrency();
+        const bool with_dtm = argv > 4 && std::string{ argc[4] } == "dtm";
+        const int men = argv > 5 ? std::stoi(argc[5]) : TB_MAX_MEN;
+        generate_tablebases(directory, threads, with_dtm, men);
         return 0;
     }
 
@@ -0,0 +1,332 @@
+// Times the building blocks of the engine on their own over a corpus of positions, in nanoseconds per operation.
+// motor_microbench [filter] [fenfile|default] runs the benchmarks whose name contains the filter,
+// motor_microbench perft_bench runs the perft suite of perft.hpp.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "perft.hpp"
+#include "search/bench.hpp"
+
+using microbench_clock = std::chrono::steady_clock;
+
+// keeps the compiler from dropping a result that is not used
+template <typename T>
+void keep(const T & value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct measurement {
+    double median = 0;
+    double min = 0;
+    double rsd = 0; // relative standard deviation of the last samples
+    int samples = 0;
+};
+
+constexpr double warmup_seconds = 0.2;
+constexpr double sample_seconds = 0.02;
+constexpr int stable_samples = 10;
+constexpr int max_samples = 100;
+constexpr double stable_rsd = 0.02;
+
+double relative_deviation(const std::vector<double> & values) {
+    double mean = 0;
+    for (const double value : values) {
+        mean += value / double(values.size());
+    }
+    double variance = 0;
+    for (const double value : values) {
+        variance += (value - mean) * (value - mean) / double(values.size() - 1);
+    }
+    return mean > 0 ? std::sqrt(variance) / mean : 0;
+}
+
+// The work returns the number of operations it did. It runs for the warmup, which also sets how many calls make a
+// sample of about 20 ms, and then in samples until the last ten of them are within 2% of each other or the limit of
+// samples is reached. The median and the minimum are over all samples.
+template <typename Work>
+measurement measure(Work && work) {
+    std::uint64_t calls = 0;
+    const auto warmup_start = microbench_clock::now();
+    double warmup = 0;
+    do {
+        keep(work());
+        calls++;
+        warmup = std::chrono::duration<double>(microbench_clock::now() - warmup_start).count();
+    } while (warmup < warmup_seconds);
+    const auto calls_per_sample = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(double(calls) * sample_seconds / warmup));
+
+    std::vector<double> samples;
+    measurement result;
+    while (static_cast<int>(samples.size()) < max_samples) {
+        std::uint64_t operations = 0;
+        const auto start = microbench_clock::now();
+        for (std::uint64_t call = 0; call < calls_per_sample; call++) {
+            operations += work();
+        }
+        const double nanoseconds = std::chrono::duration<double, std::nano>(microbench_clock::now() - start).count();
+        samples.push_back(nanoseconds / double(std::max<std::uint64_t>(1, operations)));
+
+        if (static_cast<int>(samples.size()) >= stable_samples) {
+            result.rsd = relative_deviation({samples.end() - stable_samples, samples.end()});
+            if (result.rsd < stable_rsd) {
+                break;
+            }
+        }
+    }
+
+    result.samples = static_cast<int>(samples.size());
+    std::ranges::sort(samples);
+    result.median = samples[samples.size() / 2];
+    result.min = samples.front();
+    return result;
+}
+
+void print_measurement(const std::string & name, const measurement & result) {
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << result.median << std::setw(12) << result.min
+              << std::setw(9) << result.rsd * 100 << "%" << std::setw(9) << result.samples
+              << (result.rsd < stable_rsd ? "" : "  unstable") << std::defaultfloat << std::endl;
+}
+
+// a position of the corpus with what the benchmarks use of it
+struct corpus_position {
+    std::unique_ptr<board> chessboard;
+    std::vector<chess_move> moves;
+
+    struct feature {
+        Piece piece;
+        Color color;
+        Square square;
+    };
+    std::vector<feature> features;
+    int white_king = 0;
+    int black_king = 0;
+};
+
+template <Color side>
+std::vector<chess_move> legal_moves(board & chessboard) {
+    stack_move_list list;
+    generate_all_moves<side>(chessboard, list);
+    std::vector<chess_move> moves;
+    for (const chess_move & move : list) {
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+// quiet knight or king move of the side, moving from `from` to `to` unless they are left out
+template <Color side>
+chess_move shuffle_move(board & chessboard, const int from = -1, const int to = -1) {
+    stack_move_list list;
+    generate_all_moves<side>(chessboard, list);
+    for (const extended_move & move : list) {
+        if (move.is_quiet() && move.get_move_type() == NORMAL && (move.get_piece() == Knight || move.get_piece() == King)
+            && (from < 0 || (move.get_from() == from && move.get_to() == to))) {
+            return move;
+        }
+    }
+    return {};
+}
+
+// Both sides move a knight or the king away and back, twice, so the position stands at the end of a history with two
+// earlier occurrences and is_draw has keys to filter and states to walk. Returns false when a move is missing.
+template <Color side>
+bool repeat_position(board & chessboard) {
+    constexpr Color other = side == White ? Black : White;
+
+    const chess_move ours = shuffle_move<side>(chessboard);
+    if (ours == chess_move{}) return false;
+    make_move<side, false>(chessboard, ours);
+
+    const chess_move theirs = shuffle_move<other>(chessboard);
+    if (theirs == chess_move{}) return false;
+    make_move<other, false>(chessboard, theirs);
+
+    const chess_move ours_back = shuffle_move<side>(chessboard, ours.get_to(), ours.get_from());
+    if (ours_back == chess_move{}) return false;
+    make_move<side, false>(chessboard, ours_back);
+
+    const chess_move theirs_back = shuffle_move<other>(chessboard, theirs.get_to(), theirs.get_from());
+    if (theirs_back == chess_move{}) return false;
+    make_move<other, false>(chessboard, theirs_back);
+
+    for (const chess_move & move : {ours, theirs, ours_back, theirs_back}) {
+        chessboard.get_side() == White ? make_move<White, false>(chessboard, move) : make_move<Black, false>(chessboard, move);
+    }
+    return true;
+}
+
+template <Color side, bool only_captures>
+std::uint64_t time_generation(board & chessboard) {
+    stack_move_list list;
+    generate_all_moves<side, only_captures>(chessboard, list);
+    keep(list.size());
+    return 1;
+}
+
+template <Color side, bool update_nnue>
+std::uint64_t time_make_undo(corpus_position & position) {
+    for (const chess_move & move : position.moves) {
+        make_move<side, update_nnue>(*position.chessboard, move);
+        undo_move<side, update_nnue>(*position.chessboard, move);
+    }
+    keep(*position.chessboard);
+    return position.moves.size();
+}
+
+template <Color side>
+std::uint64_t time_see(corpus_position & position) {
+    see_context see_ctx(*position.chessboard);
+    for (const chess_move & move : position.moves) {
+        keep(see_ctx.see<side>(move));
+    }
+    return position.moves.size();
+}
+
+template <Color side>
+std::uint64_t time_perft(board & chessboard) {
+    return perft<side>(chessboard, 3);
+}
+
+int main(int argc, char * argv[]) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    const std::string fen_file = argc > 2 ? argv[2] : "default";
+
+    if (filter == "perft_bench") {
+        perft_bench();
+        return 0;
+    }
+
+    std::vector<corpus_position> corpus;
+    for (const std::string & fen : bench_positions(fen_file)) {
+        corpus_position & position = corpus.emplace_back();
+        position.chessboard = std::make_unique<board>();
+        board & chessboard = *position.chessboard;
+        chessboard.fen_to_board(fen);
+        // a position whose pieces cannot shuffle is timed without history, the walk then stops at the filter
+        if (!(chessboard.get_side() == White ? repeat_position<White>(chessboard) : repeat_position<Black>(chessboard))) {
+            chessboard.fen_to_board(fen);
+        }
+        position.moves = chessboard.get_side() == White ? legal_moves<White>(chessboard) : legal_moves<Black>(chessboard);
+
+        position.white_king = lsb(chessboard.get_pieces(White, King));
+        position.black_king = lsb(chessboard.get_pieces(Black, King));
+        for (const Color color : {White, Black}) {
+            for (const Piece piece : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+                for (std::uint64_t pieces = chessboard.get_pieces(color, piece); pieces;) {
+                    position.features.push_back({piece, color, pop_lsb(pieces)});
+                }
+            }
+        }
+    }
+
+    if (corpus.empty()) {
+        std::cout << "no positions in " << fen_file << std::endl;
+        return 1;
+    }
+    set_position(*corpus.front().chessboard);
+
+    std::cout << corpus.size() << " positions, ns per operation\n"
+              << std::left << std::setw(26) << "benchmark" << std::right << std::setw(12) << "median"
+              << std::setw(12) << "min" << std::setw(10) << "rsd" << std::setw(9) << "samples" << std::endl;
+
+    auto run = [&](const std::string & name, auto && work) {
+        if (name.find(filter) != std::string::npos) {
+            print_measurement(name, measure(work));
+        }
+    };
+
+    // per position
+    auto over_corpus = [&](auto && white, auto && black) {
+        return [&, white, black] {
+            std::uint64_t operations = 0;
+            for (corpus_position & position : corpus) {
+                operations += position.chessboard->get_side() == White ? white(position) : black(position);
+            }
+            return operations;
+        };
+    };
+
+    run("movegen_all", over_corpus([](corpus_position & p) { return time_generation<White, false>(*p.chessboard); },
+                                   [](corpus_position & p) { return time_generation<Black, false>(*p.chessboard); }));
+    run("movegen_captures", over_corpus([](corpus_position & p) { return time_generation<White, true>(*p.chessboard); },
+                                        [](corpus_position & p) { return time_generation<Black, true>(*p.chessboard); }));
+    run("make_undo", over_corpus([](corpus_position & p) { return time_make_undo<White, false>(p); },
+                                 [](corpus_position & p) { return time_make_undo<Black, false>(p); }));
+    run("make_undo_nnue", over_corpus([](corpus_position & p) { return time_make_undo<White, true>(p); },
+                                      [](corpus_position & p) { return time_make_undo<Black, true>(p); }));
+
+    // the accumulator values do not matter for the time, every feature is added and taken away again
+    auto both_perspectives = [](corpus_position & p) -> std::uint64_t {
+        for (const auto & [piece, color, square] : p.features) {
+            network.update_accumulator<Operation::Set>(piece, color, square, p.white_king, p.black_king);
+            network.update_accumulator<Operation::Unset>(piece, color, square, p.white_king, p.black_king);
+        }
+        return 2 * p.features.size();
+    };
+    auto one_perspective = [](corpus_position & p) -> std::uint64_t {
+        for (const auto & [piece, color, square] : p.features) {
+            network.update_accumulator<Operation::Set, White>(piece, color, square, p.white_king);
+            network.update_accumulator<Operation::Unset, White>(piece, color, square, p.white_king);
+        }
+        return 2 * p.features.size();
+    };
+    auto refresh = [](corpus_position & p) -> std::uint64_t {
+        set_position(*p.chessboard);
+        return 1;
+    };
+    run("accumulator_update", over_corpus(both_perspectives, both_perspectives));
+    run("accumulator_update_one", over_corpus(one_perspective, one_perspective));
+    run("accumulator_refresh", over_corpus(refresh, refresh));
+    set_position(*corpus.front().chessboard);
+
+    run("nnue_evaluate", over_corpus([](corpus_position &) { keep(network.evaluate<White>()); return std::uint64_t{1}; },
+                                     [](corpus_position &) { keep(network.evaluate<Black>()); return std::uint64_t{1}; }));
+    run("see", over_corpus([](corpus_position & p) { return time_see<White>(p); },
+                           [](corpus_position & p) { return time_see<Black>(p); }));
+    run("is_draw", over_corpus([](corpus_position & p) { keep(p.chessboard->is_draw(0)); return std::uint64_t{1}; },
+                               [](corpus_position & p) { keep(p.chessboard->is_draw(0)); return std::uint64_t{1}; }));
+    run("perft_3", over_corpus([](corpus_position & p) { return time_perft<White>(*p.chessboard); },
+                               [](corpus_position & p) { return time_perft<Black>(*p.chessboard); }));
+
+    // random keys into tables that are filled first, so the probes reach memory as they do in a long search
+    std::vector<std::uint64_t> keys(1 << 16);
+    std::mt19937_64 random(2024);
+    std::ranges::generate(keys, random);
+
+    for (const int megabytes : {1, 16, 256}) {
+        const std::string size = std::to_string(megabytes) + "mb";
+        if (("tt_retrieve_" + size).find(filter) == std::string::npos && ("tt_store_" + size).find(filter) == std::string::npos) {
+            continue;
+        }
+
+        auto table = std::make_unique<transposition_table<TT_cluster>>(std::uint64_t(megabytes) * 1024 * 1024);
+        std::mt19937_64 fill(megabytes);
+        for (std::uint64_t i = 0; i < table->byte_size() / sizeof(TT_entry); i++) {
+            table->store(Bound::EXACT, 5, 0, 0, {}, 0, false, fill());
+        }
+
+        run("tt_retrieve_" + size, [&] {
+            for (const std::uint64_t key : keys) {
+                keep(table->retrieve(key, 0));
+            }
+            return std::uint64_t(keys.size());
+        });
+        run("tt_store_" + size, [&] {
+            for (const std::uint64_t key : keys) {
+                table->store(Bound::LOWER, 7, 25, 10, {}, 0, false, key);
+            }
+            return std::uint64_t(keys.size());
+        });
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 #include "../chess_board/board.hpp"
 #include "move_list.hpp"
+#include "../profiler.hpp"
 
 template<Color side, bool in_check, bool only_captures>
 void generate_promotions(const board & pos, std::uint64_t source, move_list &moves) {
@@ -32,24 +33,26 @@ void generate_promotions(const board & pos, std::uint64_t source, move_list &mov
         while(left_promotions) {
             Square to = pop_lsb(left_promotions);
             Square from = to - up_left;
-            moves.push_back(chess_move(from, to, PROMOTION, QueenPromotion));
+            const Piece captured = pos.get_piece(to);
+            moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, QueenPromotion));
 
             if constexpr (!only_captures) {
-                moves.push_back(chess_move(from, to, PROMOTION, KnightPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, RookPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, BishopPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, KnightPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, RookPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, BishopPromotion));
             }
         }
 
         while(right_promotions) {
             const Square to = pop_lsb(right_promotions);
             const Square from = to - up_right;
-            moves.push_back(chess_move(from, to, PROMOTION, QueenPromotion));
+            const Piece captured = pos.get_piece(to);
+            moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, QueenPromotion));
 
             if constexpr (!only_captures) {
-                moves.push_back(chess_move(from, to, PROMOTION, KnightPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, RookPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, BishopPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, KnightPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, RookPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, captured, BishopPromotion));
             }
         }
 
@@ -62,50 +65,62 @@ void generate_promotions(const board & pos, std::uint64_t source, move_list &mov
         while(quiet_promotions) {
             Square to = pop_lsb(quiet_promotions);
             Square from = to - up;
-            moves.push_back(chess_move(from, to, PROMOTION, QueenPromotion));
+            moves.push_back(extended_move(from, to, PROMOTION, Pawn, Null_Piece, QueenPromotion));
 
             if constexpr (!only_captures) {
-                moves.push_back(chess_move(from, to, PROMOTION, KnightPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, RookPromotion));
-                moves.push_back(chess_move(from, to, PROMOTION, BishopPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, Null_Piece, KnightPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, Null_Piece, RookPromotion));
+                moves.push_back(extended_move(from, to, PROMOTION, Pawn, Null_Piece, BishopPromotion));
             }
         }
     }
 }
 
+// Pawns from source that can legally capture en passant
 template<Color side, bool in_check>
-void generate_enpassant(const board &pos, std::uint64_t source, move_list &moves) {
+std::uint64_t enpassant_sources(const board &pos, std::uint64_t source) {
     constexpr Color their_side = side == White ? Black : White;
     constexpr Direction pawn_direction = side == White ? NORTH : SOUTH;
 
-    Square ep_square = pos.enpassant_square();
-    // Enpassant
-    if (ep_square != Square::Null_Square) {
-        std::uint64_t orthogonal_pins = pos.pin_orthogonal();
-        std::uint64_t diagonal_pins = pos.pin_diagonal();
-        std::uint64_t checkmask = pos.checkmask();
+    const Square ep_square = pos.enpassant_square();
+    if (ep_square == Square::Null_Square) {
+        return 0ull;
+    }
 
-        std::uint64_t capture = bb(pos.enpassant_square() - pawn_direction); // Pawn who will be captured enpassant
-        std::uint64_t enpassants = PAWN_ATTACKS_TABLE[their_side][pos.enpassant_square()] & source & ~orthogonal_pins;
+    const std::uint64_t orthogonal_pins = pos.pin_orthogonal();
+    const std::uint64_t diagonal_pins = pos.pin_diagonal();
+    const std::uint64_t capture = bb(ep_square - pawn_direction); // Pawn who will be captured enpassant
+    std::uint64_t enpassants = PAWN_ATTACKS_TABLE[their_side][ep_square] & source & ~orthogonal_pins;
 
-        if constexpr (in_check) {
-            if (!(pos.checkers() & capture)) {
-                enpassants &= checkmask;
-            }
+    if constexpr (in_check) {
+        if (!(pos.checkers() & capture)) {
+            enpassants &= pos.checkmask();
         }
+    }
 
-        while(enpassants) {
-            Square from = pop_lsb(enpassants);
+    std::uint64_t legal = 0ull;
+    while(enpassants) {
+        const Square from = pop_lsb(enpassants);
 
-            if ((bb(from) & diagonal_pins) && !(bb(ep_square) & diagonal_pins))
-                continue;
+        if ((bb(from) & diagonal_pins) && !(bb(ep_square) & diagonal_pins))
+            continue;
 
-            if (!(attacks<Ray::HORIZONTAL>(pos.get_king_square<side>(), pos.get_occupancy() ^ bb(from) ^ capture) & pos.get_orthogonal_pieces<their_side>()) )
-            {
-                moves.push_back(chess_move(from, ep_square, EN_PASSANT));
-            }
+        if (!(attacks<Ray::HORIZONTAL>(pos.get_king_square<side>(), pos.get_occupancy() ^ bb(from) ^ capture) & pos.get_orthogonal_pieces<their_side>()))
+        {
+            legal |= bb(from);
         }
     }
+    return legal;
+}
+
+template<Color side, bool in_check>
+void generate_enpassant(const board &pos, std::uint64_t source, move_list &moves) {
+    std::uint64_t enpassants = enpassant_sources<side, in_check>(pos, source);
+
+    while(enpassants) {
+        const Square from = pop_lsb(enpassants);
+        moves.push_back(extended_move(from, pos.enpassant_square(), EN_PASSANT, Pawn, Null_Piece));
+    }
 }
 
 template<Color side, bool in_check, bool only_captures>
@@ -136,13 +151,13 @@ void generate_pawn_pushes_moves(const board &pos, uint64_t source, move_list &mo
         while(single_pushes) {
             const Square to = pop_lsb(single_pushes);
             const Square from = to - Up;
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, Pawn, Null_Piece));
         }
 
         while(double_pushes) {
             const Square to = pop_lsb(double_pushes);
             const Square from = to - Up - Up;
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, Pawn, Null_Piece));
         }
     }
 
@@ -159,13 +174,13 @@ void generate_pawn_pushes_moves(const board &pos, uint64_t source, move_list &mo
     while(left_captures) {
         const Square to = pop_lsb(left_captures);
         const Square from = to - UpLeft;
-        moves.push_back(chess_move(from, to, NORMAL));
+        moves.push_back(extended_move(from, to, NORMAL, Pawn, pos.get_piece(to)));
     }
 
     while(right_captures) {
         const Square to = pop_lsb(right_captures);
         const Square from = to - UpRight;
-        moves.push_back(chess_move(from, to, NORMAL));
+        moves.push_back(extended_move(from, to, NORMAL, Pawn, pos.get_piece(to)));
     }
 }
 
@@ -183,8 +198,8 @@ void generate_castling_moves(const board &pos, move_list &moves) {
     constexpr Square king_from = side == White ? E1 : E8;
     constexpr Square kingside_to = side == White ? G1 : G8;
     constexpr Square queenside_to = side == White ? C1 : C8;
-    constexpr chess_move kingside_castle = chess_move(king_from, kingside_to, CASTLING);
-    constexpr chess_move queenside_castle = chess_move(king_from, queenside_to, CASTLING);
+    constexpr extended_move kingside_castle = extended_move(king_from, kingside_to, CASTLING, King, Null_Piece);
+    constexpr extended_move queenside_castle = extended_move(king_from, queenside_to, CASTLING, King, Null_Piece);
 
     const std::uint64_t occupancy = pos.get_occupancy();
     const std::uint64_t attacked_squares = pos.checked_squares();
@@ -207,7 +222,7 @@ void generate_king_moves(const board &pos, Square from, move_list &moves) {
 
     while(dest) {
         const Square to = pop_lsb(dest);
-        moves.push_back(chess_move(from, to, NORMAL));
+        moves.push_back(extended_move(from, to, NORMAL, King, pos.get_piece(to)));
     }
 }
 
@@ -225,7 +240,7 @@ void generate_knight_moves(const board &pos, std::uint64_t source, move_list &mo
 
         while (dest) {
             const Square to = pop_lsb(dest);
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, Knight, pos.get_piece(to)));
         }
     }
 }
@@ -241,6 +256,7 @@ void generate_bishop_moves(const board &pos, std::uint64_t source, move_list &mo
     std::uint64_t pieces = source & ~orthogonal_pins & ~diagonal_pins;
     while(pieces) {
         const Square from = pop_lsb(pieces);
+        const Piece piece = pos.get_piece(from);
         std::uint64_t dest = attacks<Ray::BISHOP>(from, pos.get_occupancy()) & ~pos.get_side_occupancy<side>();
 
         if constexpr (in_check) dest &= pos.checkmask();
@@ -248,7 +264,7 @@ void generate_bishop_moves(const board &pos, std::uint64_t source, move_list &mo
 
         while(dest) {
             const Square to = pop_lsb(dest);
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, piece, pos.get_piece(to)));
         }
     }
 
@@ -256,6 +272,7 @@ void generate_bishop_moves(const board &pos, std::uint64_t source, move_list &mo
     pieces = source & ~orthogonal_pins & diagonal_pins;
     while (pieces) {
         const Square from = pop_lsb(pieces);
+        const Piece piece = pos.get_piece(from);
         std::uint64_t dest = attacks<Ray::BISHOP>(from, pos.get_occupancy()) & ~pos.get_side_occupancy<side>() & diagonal_pins;
 
         if constexpr (in_check) dest &= pos.checkmask();
@@ -263,7 +280,7 @@ void generate_bishop_moves(const board &pos, std::uint64_t source, move_list &mo
 
         while(dest) {
             const Square to = pop_lsb(dest);
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, piece, pos.get_piece(to)));
         }
     }
 }
@@ -279,6 +296,7 @@ void generate_rook_moves(const board &pos, std::uint64_t source, move_list &move
     std::uint64_t rooks = source & ~diagonal_pins & ~orthogonal_pins;
     while(rooks) {
         const Square from = pop_lsb(rooks);
+        const Piece piece = pos.get_piece(from);
         std::uint64_t dest = attacks<Ray::ROOK>(from, pos.get_occupancy()) & ~pos.get_side_occupancy<side>();
 
         if constexpr (in_check) dest &= pos.checkmask();
@@ -286,7 +304,7 @@ void generate_rook_moves(const board &pos, std::uint64_t source, move_list &move
 
         while(dest) {
             Square to = pop_lsb(dest);
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, piece, pos.get_piece(to)));
         }
     }
 
@@ -294,6 +312,7 @@ void generate_rook_moves(const board &pos, std::uint64_t source, move_list &move
     rooks = source & ~diagonal_pins & orthogonal_pins;
     while(rooks) {
         Square from = pop_lsb(rooks);
+        const Piece piece = pos.get_piece(from);
         std::uint64_t dest = attacks<Ray::ROOK>(from, pos.get_occupancy()) & ~pos.get_side_occupancy<side>() & orthogonal_pins;
 
         if constexpr (in_check) dest &= pos.checkmask();
@@ -301,14 +320,14 @@ void generate_rook_moves(const board &pos, std::uint64_t source, move_list &move
 
         while(dest) {
             Square to = pop_lsb(dest);
-            moves.push_back(chess_move(from, to, NORMAL));
+            moves.push_back(extended_move(from, to, NORMAL, piece, pos.get_piece(to)));
         }
     }
 }
 
 template<Color side, bool only_captures = false>
 void generate_all_moves(board &pos, move_list &moves) {
-    pos.calculate_pins<side>();
+    PROFILE_SECTION(Move_Generation);
     switch(popcount(pos.checkers())) {
         case 0:
             generate_pawn_moves<side, false, only_captures>(pos, pos.get_pieces(side, Pawn), moves);
@@ -331,4 +350,102 @@ void generate_all_moves(board &pos, move_list &moves) {
     }
 }
 
+template<Color side, bool in_check>
+int count_pawn_moves(const board &pos, std::uint64_t source) {
+    constexpr Color their_side = side == White ? Black : White;
+    constexpr std::uint64_t Rank3 = (side == White) ? ranks[RANK_3] : ranks[RANK_6];
+    constexpr std::uint64_t Rank8 = (side == White) ? ranks[RANK_8] : ranks[RANK_1];
+    constexpr Direction Up = (side == White) ? NORTH : SOUTH;
+    constexpr Direction UpLeft = (side == White) ?  NORTH_WEST : SOUTH_EAST;
+    constexpr Direction UpRight = (side == White) ? NORTH_EAST : SOUTH_WEST;
+
+    const std::uint64_t empty = ~pos.get_occupancy();
+    const std::uint64_t enemy = pos.get_side_occupancy<their_side>();
+    const std::uint64_t orthogonal_pin = pos.pin_orthogonal();
+    const std::uint64_t diagonal_pin = pos.pin_diagonal();
+
+    std::uint64_t pawns = source & ~diagonal_pin;
+    std::uint64_t single_pushes = (shift<Up>(pawns & ~orthogonal_pin) | (shift<Up>(pawns & orthogonal_pin) & orthogonal_pin)) & empty;
+    std::uint64_t double_pushes = shift<Up>(single_pushes & Rank3) & empty;
+
+    pawns = source & ~orthogonal_pin;
+    std::uint64_t left_captures = (shift<UpLeft>(pawns & ~diagonal_pin) | (shift<UpLeft>(pawns & diagonal_pin) & diagonal_pin)) & enemy;
+    std::uint64_t right_captures = (shift<UpRight>(pawns & ~diagonal_pin) | (shift<UpRight>(pawns & diagonal_pin) & diagonal_pin)) & enemy;
+
+    if constexpr (in_check) {
+        const std::uint64_t checkmask = pos.checkmask();
+        single_pushes &= checkmask;
+        double_pushes &= checkmask;
+        left_captures &= checkmask;
+        right_captures &= checkmask;
+    }
+
+    // every pawn move to the last rank is four promotions
+    return popcount(single_pushes & ~Rank8) + popcount(left_captures & ~Rank8) + popcount(right_captures & ~Rank8)
+           + 4 * (popcount(single_pushes & Rank8) + popcount(left_captures & Rank8) + popcount(right_captures & Rank8))
+           + popcount(double_pushes)
+           + popcount(enpassant_sources<side, in_check>(pos, source));
+}
+
+template<Color side, bool in_check>
+int count_piece_moves(const board &pos) {
+    const std::uint64_t targets = in_check ? ~pos.get_side_occupancy<side>() & pos.checkmask() : ~pos.get_side_occupancy<side>();
+    const std::uint64_t occupancy = pos.get_occupancy();
+    const std::uint64_t orthogonal_pins = pos.pin_orthogonal();
+    const std::uint64_t diagonal_pins = pos.pin_diagonal();
+
+    int count = 0;
+
+    std::uint64_t knights = pos.get_pieces(side, Knight) & ~(diagonal_pins | orthogonal_pins);
+    while (knights) {
+        count += popcount(KNIGHT_ATTACKS[pop_lsb(knights)] & targets);
+    }
+
+    std::uint64_t bishops = pos.get_diagonal_pieces<side>() & ~orthogonal_pins;
+    while (bishops) {
+        const Square from = pop_lsb(bishops);
+        const std::uint64_t pin = (bb(from) & diagonal_pins) ? diagonal_pins : full_board;
+        count += popcount(attacks<Ray::BISHOP>(from, occupancy) & targets & pin);
+    }
+
+    std::uint64_t rooks = pos.get_orthogonal_pieces<side>() & ~diagonal_pins;
+    while (rooks) {
+        const Square from = pop_lsb(rooks);
+        const std::uint64_t pin = (bb(from) & orthogonal_pins) ? orthogonal_pins : full_board;
+        count += popcount(attacks<Ray::ROOK>(from, occupancy) & targets & pin);
+    }
+
+    return count + count_pawn_moves<side, in_check>(pos, pos.get_pieces(side, Pawn));
+}
+
+template<Color side>
+int count_king_moves(const board &pos) {
+    return popcount(KING_ATTACKS[pos.get_king_square<side>()] & ~pos.get_side_occupancy<side>() & ~pos.checked_squares());
+}
+
+template<Color side>
+int count_castling_moves(const board &pos) {
+    constexpr CastlingRight kingside = side == White ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE;
+    constexpr CastlingRight queenside = side == White ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE;
+
+    const std::uint64_t occupancy = pos.get_occupancy();
+    const std::uint64_t attacked_squares = pos.checked_squares();
+
+    return (pos.can_castle(kingside) && !((occupancy | attacked_squares) & CastlingPath[kingside]))
+           + (pos.can_castle(queenside) && !((occupancy & CastlingPath[queenside]) | (attacked_squares & CastlingKingPath[queenside])));
+}
+
+// Number of legal moves, computed from target bitboards without emitting any move
+template<Color side>
+int count_legal_moves(const board &pos) {
+    switch(popcount(pos.checkers())) {
+        case 0:
+            return count_piece_moves<side, false>(pos) + count_castling_moves<side>(pos) + count_king_moves<side>(pos);
+        case 1:
+            return count_piece_moves<side, true>(pos) + count_king_moves<side>(pos);
+        default:
+            return count_king_moves<side>(pos);
+    }
+}
+
 #endif //MOTOR_MOVE_GENERATOR_HPP
\ No newline at end of file
@@ -1,59 +1,253 @@
 #ifndef MOTOR_MOVE_LIST_HPP
 #define MOTOR_MOVE_LIST_HPP
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <memory>
+#include <new>
 #include <utility>
+#include <immintrin.h>
 #include "../chess_board/chess_move.hpp"
 
+struct scored_move {
+    extended_move move;
+    std::int32_t score;
+};
+
+// the vector scan for the best move pays off from this many remaining moves, shorter lists such as those of the
+// quiescence search are scanned one move at a time
+constexpr std::uint8_t vector_scan_from = 16;
+
+// View of the moves of one position, the storage is provided by stack_move_list or arena_move_list
 class move_list {
 private:
-    std::array<chess_move, 256> list;
-    std::array<std::int32_t, 256> move_score;
+    scored_move * list;
     std::uint8_t count;
+
+    template <typename entry_type, typename move_type>
+    class move_iterator {
+    public:
+        explicit move_iterator(entry_type * entry) : entry(entry) {}
+
+        move_type & operator*() const { return entry->move; }
+        move_type * operator->() const { return &entry->move; }
+
+        move_iterator & operator++() {
+            ++entry;
+            return *this;
+        }
+
+        bool operator==(const move_iterator & other) const { return entry == other.entry; }
+        bool operator!=(const move_iterator & other) const { return entry != other.entry; }
+
+    private:
+        entry_type * entry;
+    };
+
 public:
-    move_list() : list{}, count{} {}
+    explicit move_list(scored_move * storage) : list(storage), count{} {}
+    move_list(const move_list &) = delete;
+    move_list & operator=(const move_list &) = delete;
 
     [[nodiscard]] std::uint8_t size() const {
         return count;
     }
 
-    void push_back(chess_move && m) {
-        list[count] = m;
+    void push_back(const extended_move & m) {
+        list[count].move = m;
         count++;
     }
 
-    void push_back(const chess_move & m) {
-        list[count] = m;
-        count++;
+    // partial selection sort, the first of equal scores goes first
+    extended_move & get_next_move(const std::uint8_t index) {
+        std::swap(list[index], list[best_index(index)]);
+        return list[index].move;
+    }
+
+    std::int32_t & operator[](int index) {
+        return list[index].score;
+    }
+
+    std::int32_t get_move_score(int index) {
+        return list[index].score;
+    }
+
+    [[nodiscard]] const extended_move & get_move(int index) const {
+        return list[index].move;
     }
 
-    // partial insertion sort
-    chess_move & get_next_move(const std::uint8_t index) {
-        uint8_t best = index;
+private:
+    // first entry with the highest score in [index, count)
+    [[nodiscard]] std::uint8_t best_index(const std::uint8_t index) const {
+#if defined(__AVX512F__) || defined(__AVX2__)
+        if (count - index >= vector_scan_from) {
+            return vector_best_index(index);
+        }
+#endif
+        std::uint8_t best = index;
         for(unsigned int i = index + 1; i < count; i++) {
-            if(move_score[i] > move_score[best]) {
+            if(list[i].score > list[best].score) {
                 best = i;
             }
         }
-        std::swap(list[index], list[best]);
-        std::swap(move_score[index], move_score[best]);
-        return list[index];
+        return best;
     }
 
-    std::int32_t & operator[](int index) {
-        return move_score[index];
+#if defined(__AVX512F__) || defined(__AVX2__)
+    // The lists start on a cache line, but the scan starts at the pick index, so the loads are unaligned on purpose.
+    [[nodiscard]] std::uint8_t vector_best_index(const std::uint8_t index) const {
+#if defined(__AVX512F__)
+        constexpr unsigned int lanes = 8;  // scored_move entries per vector, the score is every odd int32
+        constexpr __mmask16 score_lanes = 0xAAAA;
+        __m512i best = _mm512_set1_epi32(INT_MIN);
+        unsigned int i = index;
+        for (; i + lanes <= count; i += lanes) {
+            best = _mm512_mask_max_epi32(best, score_lanes, best, _mm512_loadu_si512(&list[i]));
+        }
+        std::int32_t best_score = _mm512_reduce_max_epi32(best);
+        for (; i < count; i++) {
+            best_score = std::max(best_score, list[i].score);
+        }
+
+        const __m512i target = _mm512_set1_epi32(best_score);
+        for (i = index; i + lanes <= count; i += lanes) {
+            const __mmask16 equal = _mm512_mask_cmpeq_epi32_mask(score_lanes, _mm512_loadu_si512(&list[i]), target);
+            if (equal) {
+                return i + std::countr_zero(static_cast<unsigned int>(equal)) / 2;
+            }
+        }
+        for (; list[i].score != best_score; i++) {}
+        return i;
+#elif defined(__AVX2__)
+        constexpr unsigned int lanes = 4;
+        constexpr int score_lanes = 0xAA;
+        const __m256i minimum = _mm256_set1_epi32(INT_MIN);
+        __m256i best = minimum;
+        unsigned int i = index;
+        for (; i + lanes <= count; i += lanes) {
+            const __m256i entries = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&list[i]));
+            best = _mm256_max_epi32(best, _mm256_blend_epi32(minimum, entries, score_lanes));
+        }
+        __m128i best_128 = _mm_max_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+        best_128 = _mm_max_epi32(best_128, _mm_shuffle_epi32(best_128, _MM_SHUFFLE(1, 0, 3, 2)));
+        best_128 = _mm_max_epi32(best_128, _mm_shuffle_epi32(best_128, _MM_SHUFFLE(2, 3, 0, 1)));
+        std::int32_t best_score = _mm_cvtsi128_si32(best_128);
+        for (; i < count; i++) {
+            best_score = std::max(best_score, list[i].score);
+        }
+
+        const __m256i target = _mm256_set1_epi32(best_score);
+        for (i = index; i + lanes <= count; i += lanes) {
+            const __m256i entries = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&list[i]));
+            const unsigned int equal = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(entries, target))) & score_lanes;
+            if (equal) {
+                return i + std::countr_zero(equal) / 2;
+            }
+        }
+        for (; list[i].score != best_score; i++) {}
+        return i;
+#endif
     }
+#endif
 
-    std::int32_t get_move_score(int index) {
-        return move_score[index];
+public:
+    typedef move_iterator<scored_move, extended_move> iterator;
+    typedef move_iterator<const scored_move, const extended_move> const_iterator;
+
+    iterator begin() { return iterator(&list[0]); }
+    const_iterator begin() const { return const_iterator(&list[0]); }
+    iterator end() { return iterator(&list[count]); }
+    const_iterator end() const { return const_iterator(&list[count]); }
+};
+
+// move lists start on a cache line, in the arena as well
+constexpr std::size_t move_list_alignment = 64;
+constexpr std::size_t entries_per_line = move_list_alignment / sizeof(scored_move);
+
+struct move_list_storage {
+    alignas(move_list_alignment) std::array<scored_move, 256> storage;
+};
+
+// move_list with its own storage for the worst case, for use outside of search
+class stack_move_list : private move_list_storage, public move_list {
+public:
+    stack_move_list() : move_list_storage(), move_list(storage.data()) {}
+};
+
+// Stack of the move lists of all plies of one search thread, every list takes only as many entries as it has moves
+class move_arena {
+public:
+    // two lists can be alive per ply because of the singular extension search
+    static constexpr std::size_t capacity = 2 * 96 * 256;
+
+    move_arena() : entries(static_cast<scored_move *>(::operator new[](capacity * sizeof(scored_move), std::align_val_t{move_list_alignment}))), top(0) {}
+
+private:
+    struct aligned_delete {
+        void operator()(scored_move * storage) const {
+            ::operator delete[](storage, std::align_val_t{move_list_alignment});
+        }
+    };
+
+    std::unique_ptr<scored_move[], aligned_delete> entries;
+    std::size_t top;
+
+    friend class arena_move_list;
+};
+
+// move_list placed on top of the move arena, its slice is released when it leaves scope
+class arena_move_list : public move_list {
+public:
+    explicit arena_move_list(move_arena & arena) : move_list(arena.entries.get() + arena.top), arena(arena), base(arena.top) {}
+
+    ~arena_move_list() {
+        arena.top = base;
     }
 
-    typedef chess_move* iterator;
-    typedef const chess_move* const_iterator;
+    // claims the generated moves, lists of deeper plies are placed on the next cache line after them
+    void commit() {
+        arena.top = base + (size() + entries_per_line - 1) / entries_per_line * entries_per_line;
+    }
 
-    iterator begin() { return &list[0]; }
-    const_iterator begin() const { return &list[0]; }
-    iterator end() { return &list[count]; }
-    const_iterator end() const { return &list[count]; }
+private:
+    move_arena & arena;
+    std::size_t base;
+};
+
+// Positions of a subset of the moves of a move_list, kept as a bitmask in the order they were added
+class move_subset {
+public:
+    move_subset() : positions{}, count{} {}
+
+    void insert(const std::uint8_t index) {
+        positions[index / 64] |= 1ull << (index % 64);
+        count++;
+    }
+
+    [[nodiscard]] std::uint8_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool contains(const std::uint8_t index) const {
+        return positions[index / 64] & (1ull << (index % 64));
+    }
+
+    template <typename Function>
+    void for_each(Function && function) const {
+        for (unsigned int word = 0; word < positions.size(); word++) {
+            std::uint64_t bits = positions[word];
+            while (bits) {
+                function(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    std::array<std::uint64_t, 4> positions;
+    std::uint8_t count;
 };
 
 #endif //MOTOR_MOVE_LIST_HPP
\ No newline at end of file
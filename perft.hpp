@@ -13,13 +13,14 @@
 template <Color side>
 std::uint64_t perft(board& b, int depth) {
     constexpr Color next_side = side == White ? Black : White;
-    move_list ml;
-    generate_all_moves<side, false>(b, ml);
 
     if (depth == 1) {
-        return ml.size();
+        return count_legal_moves<side>(b);
     }
 
+    stack_move_list ml;
+    generate_all_moves<side, false>(b, ml);
+
     std::uint64_t nodes = 0;
     for (const auto move : ml) {
         make_move<side, false>(b, move);
@@ -41,7 +42,7 @@ std::uint64_t perft(board & b, int depth) {
 template <Color side>
 std::uint64_t perft_debug(board & b, int depth) {
     constexpr Color next_side = (side == White) ? Black : White;
-    move_list ml;
+    stack_move_list ml;
     generate_all_moves<side, false>(b, ml);
     std::uint64_t total_nodes = 0;
     std::vector<std::string> moves;
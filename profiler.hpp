@@ -0,0 +1,123 @@
+#ifndef MOTOR_PROFILER_HPP
+#define MOTOR_PROFILER_HPP
+
+// Scoped cycle counters on the hot sections of the search. They are only compiled in with MOTOR_PROFILE defined
+// (cmake -DMOTOR_PROFILE=ON or make PROFILE=1), without it PROFILE_SECTION is empty and nothing of this file is built.
+#ifdef MOTOR_PROFILE
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+enum class Section : std::uint8_t {
+    Make_Move, Accumulator, Evaluate, Move_Generation, Move_Ordering, See, TT_Probe, TT_Store, Count
+};
+
+constexpr std::array<const char *, static_cast<int>(Section::Count)> section_names = {
+    "make_move", "accumulator", "evaluate", "movegen", "score_moves", "see", "tt_probe", "tt_store"
+};
+
+inline std::uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct section_counts {
+    std::array<std::uint64_t, static_cast<int>(Section::Count)> cycles = {};
+    std::array<std::uint64_t, static_cast<int>(Section::Count)> calls = {};
+};
+
+// Every thread counts into its own section_counts, which stay registered after the thread ends so that they can be
+// summed once the threads are done.
+class section_profiler {
+public:
+    static section_counts & local() {
+        thread_local section_counts & counts = instance().add_thread();
+        return counts;
+    }
+
+    static section_profiler & instance() {
+        static section_profiler profiler;
+        return profiler;
+    }
+
+    [[nodiscard]] section_counts total() {
+        std::lock_guard lock(mutex);
+        section_counts sum;
+        for (const auto & counts : threads) {
+            for (int i = 0; i < static_cast<int>(Section::Count); i++) {
+                sum.cycles[i] += counts->cycles[i];
+                sum.calls[i] += counts->calls[i];
+            }
+        }
+        return sum;
+    }
+
+    void clear() {
+        std::lock_guard lock(mutex);
+        for (const auto & counts : threads) {
+            *counts = {};
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<section_counts>> threads;
+
+    section_counts & add_thread() {
+        std::lock_guard lock(mutex);
+        return *threads.emplace_back(std::make_unique<section_counts>());
+    }
+};
+
+// counts the cycles of its scope without the ones of the scopes inside it, so the sections add up
+class profile_scope {
+public:
+    explicit profile_scope(Section section) : section(static_cast<int>(section)), parent(active) {
+        active = this;
+        start = read_cycles();
+    }
+
+    ~profile_scope() {
+        const std::uint64_t elapsed = read_cycles() - start;
+        section_counts & counts = section_profiler::local();
+        counts.cycles[section] += elapsed - inner;
+        counts.calls[section]++;
+
+        if (parent) {
+            parent->inner += elapsed;
+        }
+        active = parent;
+    }
+
+    profile_scope(const profile_scope &) = delete;
+    profile_scope & operator=(const profile_scope &) = delete;
+
+private:
+    static inline thread_local profile_scope * active = nullptr;
+
+    int section;
+    profile_scope * parent;
+    std::uint64_t start = 0;
+    std::uint64_t inner = 0;
+};
+
+#define PROFILE_SECTION(name) const profile_scope section_probe(Section::name)
+
+#else
+
+#define PROFILE_SECTION(name)
+
+#endif
+
+#endif //MOTOR_PROFILER_HPP
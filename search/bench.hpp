@@ -1,7 +1,14 @@
 #ifndef MOTOR_BENCH_HPP
 #define MOTOR_BENCH_HPP
 
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
 #include "search.hpp"
+#include "perf_counters.hpp"
 
 const std::string fens[] = { 
     "r3k2r/2pb1ppp/2pp1q2/p7/1nP1B3/1P2P3/P2N1PPP/R2QK2R w KQkq a6 0 14",
@@ -56,39 +63,302 @@ const std::string fens[] = {
     "2r2b2/5p2/5k2/p1r1pP2/P2pB3/1P3P2/K1P3R1/7R w - - 23 93"
 };
 
+// the counters of all bench positions together
+SEARCH_STAT(search_stats bench_stats;)
+
 template <Color color>
 std::uint64_t bench_iterative_deepening(board& chessboard, int max_depth) {
-    search_data data;
+    search_data data(history->sentinel(), history->continuation({}));
     time_info info;
     data.set_timekeeper(info.wtime, info.winc, info.movestogo, 1, INT_MAX / 2);
 
     int score;
     for (int depth = 1; depth <= max_depth; depth++) {
+        SEARCH_STAT(const std::uint64_t iteration_start = data.searched_nodes());
         if (depth < 6) {
             score = alpha_beta<color, NodeType::Root>(chessboard, data, -10'000, 10'000, depth, false);
         } else {
             score = aspiration_window<color>(chessboard, data, score, depth);
         }
+        SEARCH_STAT(data.stats.iteration_nodes.push_back(data.searched_nodes() - iteration_start));
     }
+    SEARCH_STAT(bench_stats += data.stats);
 
     return data.searched_nodes();
 }
 
-void bench(int depth) {
-	std::uint64_t nodes = 0;
+// the counters per node, with instructions per cycle after the instructions
+std::string counters_per_node(const perf_counters & counters, const counter_values & values, std::uint64_t nodes) {
+    std::stringstream line;
+    line << std::fixed << std::setprecision(2);
+    for (int i = 0; i < static_cast<int>(Counter::Count); i++) {
+        line << " " << counter_names[i] << " ";
+        if (counters.available(static_cast<Counter>(i))) {
+            line << values[i] / double(std::max<std::uint64_t>(1, nodes));
+        } else {
+            line << "n/a";
+        }
+
+        if (static_cast<Counter>(i) == Counter::Instructions) {
+            line << " ipc ";
+            if (counters.available(Counter::Cycles) && counters.available(Counter::Instructions) && values[static_cast<int>(Counter::Cycles)] > 0) {
+                line << values[i] / values[static_cast<int>(Counter::Cycles)];
+            } else {
+                line << "n/a";
+            }
+        }
+    }
+    return line.str();
+}
+
+// bench [depth] [threads] [hashMB] [fenfile|default] [runs] with json and perf allowed anywhere after bench
+struct bench_options {
+    int depth = 13;
+    int threads = 1;
+    int hash = 32;
+    std::string fen_file = "default";
+    int runs = 1;
+    bool json = false;
+    bool hardware_counters = false;
+};
+
+bench_options parse_bench_options(const std::vector<std::string> & tokens) {
+    bench_options options;
+    std::vector<std::string> values;
+    for (const std::string & token : tokens) {
+        if (token == "json") {
+            options.json = true;
+        } else if (token == "perf") {
+            options.hardware_counters = true;
+        } else {
+            values.push_back(token);
+        }
+    }
+
+    if (values.size() > 0) options.depth = std::clamp(std::stoi(values[0]), 1, 64);
+    if (values.size() > 1) options.threads = std::max(1, std::stoi(values[1]));
+    if (values.size() > 2) options.hash = std::clamp(std::stoi(values[2]), 1, 1024);
+    if (values.size() > 3) options.fen_file = values[3];
+    if (values.size() > 4) options.runs = std::max(1, std::stoi(values[4]));
+    return options;
+}
+
+// the built in positions or one fen per line of the file
+std::vector<std::string> bench_positions(const std::string & fen_file) {
+    if (fen_file == "default") {
+        return {std::begin(fens), std::end(fens)};
+    }
+
+    std::vector<std::string> positions;
+    std::ifstream file(fen_file);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            positions.push_back(line.substr(0, line.find_last_not_of(" \t\r") + 1));
+        }
+    }
+    return positions;
+}
+
+std::string json_string(const std::string & text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Searches every position to the depth, starting each run with a cleared hash table and history, and prints the
+// nodes, time and nps of every position, the nps of the runs and the node signature. The last line is the usual
+// "nodes nps" line with the mean nps of the runs. The search has a single thread, so more threads are not used.
+// Returns the nodes of one run.
+std::uint64_t bench(const bench_options & options) {
+    const std::vector<std::string> positions = bench_positions(options.fen_file);
+    if (positions.empty()) {
+        std::cout << "info string no positions in " << options.fen_file << std::endl;
+        return 0;
+    }
+
+    if (options.threads > 1 && !options.json) {
+        std::cout << "info string the search has one thread, bench runs with 1 thread" << std::endl;
+    }
 
+    std::unique_ptr<perf_counters> counters;
+    if (options.hardware_counters) {
+        counters = std::make_unique<perf_counters>();
+        if (!counters->any_available()) {
+            if (!options.json) {
+                std::cout << "info string hardware counters not available: " << counters->open_error() << std::endl;
+            }
+            counters.reset();
+        }
+    }
+
+    struct position_result {
+        std::uint64_t nodes = 0;
+        double seconds = 0;
+        counter_values counts = {};
+    };
+
+    const std::uint64_t table_size = tt.byte_size();
+    tt.resize(std::uint64_t(options.hash) * 1024 * 1024);
+    SEARCH_STAT(bench_stats = {});
+
+    std::vector<position_result> results(positions.size());
+    std::vector<double> run_nps;
+    std::uint64_t signature = 0;
+    bool deterministic = true;
     board b;
-    auto start = std::chrono::steady_clock::now();
 
-    for (const auto & fen : fens) {
-        b.fen_to_board(fen);
-        set_position(b);
-        nodes += (b.get_side() == Color::White) ? bench_iterative_deepening<Color::White>(b, depth) : bench_iterative_deepening<Color::Black>(b, depth);
+    for (int run = 0; run < options.runs; run++) {
+        tt.clear();
+        history->clear();
+        std::uint64_t run_nodes = 0;
+        double run_seconds = 0;
+
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            b.fen_to_board(positions[i]);
+            set_position(b);
+
+            if (counters) {
+                counters->start();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            const std::uint64_t nodes = (b.get_side() == Color::White) ? bench_iterative_deepening<Color::White>(b, options.depth) : bench_iterative_deepening<Color::Black>(b, options.depth);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (counters) {
+                counters->stop();
+                const counter_values counts = counters->read();
+                for (std::size_t counter = 0; counter < counts.size(); counter++) {
+                    results[i].counts[counter] += counts[counter];
+                }
+            }
+
+            results[i].nodes = nodes;
+            results[i].seconds += seconds;
+            run_nodes += nodes;
+            run_seconds += seconds;
+        }
+
+        if (run == 0) {
+            signature = run_nodes;
+        }
+        deterministic = deterministic && run_nodes == signature;
+        run_nps.push_back(double(run_nodes) / std::max(run_seconds, 1e-9));
+    }
+
+    tt.resize(table_size);
+    tt.clear();
+    history->clear();
+
+    double mean = 0;
+    for (const double nps : run_nps) {
+        mean += nps / double(run_nps.size());
+    }
+    double variance = 0;
+    for (const double nps : run_nps) {
+        variance += (nps - mean) * (nps - mean) / double(std::max<std::size_t>(1, run_nps.size() - 1));
     }
+    const double stddev = std::sqrt(variance);
 
-    auto end = std::chrono::steady_clock::now();
-    double nps = static_cast<double>(nodes) / std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
-    std::cout << nodes << " nodes " << static_cast<int>(nps) << " nps" << std::endl;
+    if (options.json) {
+        std::cout << std::fixed << std::setprecision(3) << "{\"depth\":" << options.depth << ",\"threads\":1,\"hash\":" << options.hash
+                  << ",\"fens\":" << json_string(options.fen_file) << ",\"runs\":" << options.runs
+                  << ",\"signature\":" << signature << ",\"deterministic\":" << (deterministic ? "true" : "false")
+                  << ",\"nps_mean\":" << mean << ",\"nps_stddev\":" << stddev << ",\"nps_runs\":[";
+        for (std::size_t run = 0; run < run_nps.size(); run++) {
+            std::cout << (run ? "," : "") << run_nps[run];
+        }
+        std::cout << "],\"positions\":[";
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            const double seconds = results[i].seconds / options.runs;
+            std::cout << (i ? "," : "") << "{\"fen\":" << json_string(positions[i]) << ",\"nodes\":" << results[i].nodes
+                      << ",\"time_ms\":" << seconds * 1000 << ",\"nps\":" << double(results[i].nodes) / std::max(seconds, 1e-9);
+            if (counters) {
+                for (int counter = 0; counter < static_cast<int>(Counter::Count); counter++) {
+                    if (counters->available(static_cast<Counter>(counter))) {
+                        std::cout << ",\"" << counter_names[counter] << "_per_node\":"
+                                  << results[i].counts[counter] / options.runs / double(std::max<std::uint64_t>(1, results[i].nodes));
+                    }
+                }
+            }
+            std::cout << "}";
+        }
+        std::cout << "]}" << std::defaultfloat << std::endl;
+        return signature;
+    }
+
+    counter_values total_counts = {};
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        const double seconds = results[i].seconds / options.runs;
+        std::cout << "position " << i + 1 << " nodes " << results[i].nodes << " time " << std::fixed << std::setprecision(1)
+                  << seconds * 1000 << " ms nps " << static_cast<std::uint64_t>(double(results[i].nodes) / std::max(seconds, 1e-9));
+        if (counters) {
+            counter_values counts = results[i].counts;
+            for (std::size_t counter = 0; counter < counts.size(); counter++) {
+                counts[counter] /= options.runs;
+                total_counts[counter] += counts[counter];
+            }
+            std::cout << counters_per_node(*counters, counts, results[i].nodes);
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+
+    if (counters) {
+        std::cout << "total nodes " << signature << counters_per_node(*counters, total_counts, signature) << std::endl;
+    }
+    if (!deterministic) {
+        std::cout << "info string the runs searched different numbers of nodes" << std::endl;
+    }
+    std::cout << "nps mean " << static_cast<std::uint64_t>(mean) << " stddev " << static_cast<std::uint64_t>(stddev)
+              << " over " << options.runs << (options.runs == 1 ? " run" : " runs") << std::endl;
+    std::cout << "signature " << signature << std::endl;
+    std::cout << signature << " nodes " << static_cast<std::uint64_t>(mean) << " nps" << std::endl;
+    SEARCH_STAT(bench_stats.print());
+    return signature;
+}
+
+// runs bench and prints the cycles each profiled section takes per node, the rest of the time is other
+void profile(int depth) {
+#ifdef MOTOR_PROFILE
+    section_profiler::instance().clear();
+    const std::uint64_t start = read_cycles();
+    bench_options options;
+    options.depth = depth;
+    const std::uint64_t nodes = std::max<std::uint64_t>(1, bench(options));
+    const std::uint64_t total = read_cycles() - start;
+    const section_counts counts = section_profiler::instance().total();
+
+    std::uint64_t sections = 0;
+    std::cout << std::left << std::setw(14) << "section" << std::right << std::setw(14) << "cycles/node"
+              << std::setw(12) << "calls/node" << std::setw(9) << "share" << "\n" << std::fixed;
+
+    auto print_row = [&](const char * name, std::uint64_t cycles, std::uint64_t calls, bool with_calls) {
+        std::cout << std::left << std::setw(14) << name << std::right << std::setprecision(1)
+                  << std::setw(14) << double(cycles) / double(nodes) << std::setw(12);
+        if (with_calls) {
+            std::cout << std::setprecision(2) << double(calls) / double(nodes);
+        } else {
+            std::cout << "";
+        }
+        std::cout << std::setprecision(1) << std::setw(8) << 100.0 * double(cycles) / double(std::max<std::uint64_t>(1, total)) << "%\n";
+    };
+
+    for (int i = 0; i < static_cast<int>(Section::Count); i++) {
+        print_row(section_names[i], counts.cycles[i], counts.calls[i], true);
+        sections += counts.cycles[i];
+    }
+    print_row("other", total - std::min(total, sections), 0, false);
+    print_row("total", total, 0, false);
+    std::cout << std::defaultfloat << std::flush;
+#else
+    (void) depth;
+    std::cout << "info string profile needs a build with MOTOR_PROFILE" << std::endl;
+#endif
 }
 
 #endif // MOTOR_BENCH_HPP
\ No newline at end of file
@@ -0,0 +1,330 @@
+#ifndef MOTOR_MATE_SEARCH_HPP
+#define MOTOR_MATE_SEARCH_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../chess_board/board.hpp"
+#include "../move_generation/move_list.hpp"
+#include "../move_generation/move_generator.hpp"
+#include "../executioner/makemove.hpp"
+
+// proof numbers are for the side to move of a node: phi is zero once it wins and delta once it loses
+constexpr std::uint32_t PN_INF = 1u << 30;
+
+struct pn_value {
+    std::uint32_t phi = 1;
+    std::uint32_t delta = 1;
+};
+
+struct pn_entry {
+    std::uint64_t key = 0;
+    pn_value value = {};
+};
+
+struct pn_cluster {
+    std::array<pn_entry, 4> entries = {};
+};
+
+// Depth-first proof number search (df-pn) of a mate in a given number of moves. The attacker moves at the OR nodes and
+// the defender at the AND nodes, both are searched from the view of their side to move so that every node takes the
+// minimum delta and the sum of phi of its children. The moves the attacker has left are part of the key of a node, so
+// a position reached with more moves to spare is another node and repetitions can not make the search loop.
+class mate_prover {
+public:
+    explicit mate_prover(std::size_t clusters) : table(clusters) {}
+
+    // proves a mate for the side to move, at the root only the moves with index % stride == offset are tried
+    bool prove(board & chessboard, int moves, const std::atomic<bool> & stop, std::uint64_t max_nodes, unsigned int offset, unsigned int stride) {
+        stop_flag = &stop;
+        node_limit = max_nodes;
+        root_offset = offset;
+        root_stride = stride;
+        node_count = 0;
+        aborted = false;
+
+        const pn_value root = chessboard.get_side() == White ? mid<White>(chessboard, moves, true, PN_INF, PN_INF, 0)
+                                                            : mid<Black>(chessboard, moves, true, PN_INF, PN_INF, 0);
+        return !aborted && root.phi == 0;
+    }
+
+    // the attacker's move that the last successful prove found at the root
+    [[nodiscard]] chess_move root_move() const {
+        return proved_root_move;
+    }
+
+    // follows the proof through the table, the line ends early if a node of it was overwritten
+    std::vector<chess_move> principal_variation(board & chessboard, int moves) {
+        std::vector<chess_move> pv;
+        chessboard.get_side() == White ? collect_pv<White>(chessboard, moves, true, pv) : collect_pv<Black>(chessboard, moves, true, pv);
+        return pv;
+    }
+
+    [[nodiscard]] std::uint64_t nodes() const {
+        return node_count;
+    }
+
+    [[nodiscard]] bool was_aborted() const {
+        return aborted;
+    }
+
+private:
+    std::vector<pn_cluster> table;
+    const std::atomic<bool> * stop_flag = nullptr;
+    std::uint64_t node_limit = 0;
+    std::uint64_t node_count = 0;
+    unsigned int root_offset = 0;
+    unsigned int root_stride = 1;
+    bool aborted = false;
+    chess_move proved_root_move = {};
+
+    static std::uint64_t node_key(std::uint64_t hash, int moves) {
+        return hash ^ (static_cast<std::uint64_t>(moves + 1) * 0x9E3779B97F4A7C15ull);
+    }
+
+    pn_cluster & cluster(std::uint64_t key) {
+        return table[static_cast<std::uint64_t>((static_cast<__int128>(key) * static_cast<__int128>(table.size())) >> 64)];
+    }
+
+    bool lookup(std::uint64_t key, pn_value & value) {
+        for (const pn_entry & entry : cluster(key).entries) {
+            if (entry.key == key) {
+                value = entry.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // solved nodes are kept over the ones still open, which are kept by the work they took
+    void store(std::uint64_t key, pn_value value) {
+        auto worth = [](const pn_entry & entry) {
+            if (entry.key == 0) return 0ull;
+            if (entry.value.phi == 0 || entry.value.delta == 0) return ~0ull;
+            return 1ull + entry.value.phi + entry.value.delta;
+        };
+
+        pn_entry * slot = &cluster(key).entries[0];
+        for (pn_entry & entry : cluster(key).entries) {
+            if (entry.key == key) {
+                slot = &entry;
+                break;
+            }
+            if (worth(entry) < worth(*slot)) {
+                slot = &entry;
+            }
+        }
+        *slot = {key, value};
+    }
+
+    static std::uint32_t add(std::uint32_t sum, std::uint32_t value) {
+        if (sum == PN_INF || value == PN_INF) {
+            return PN_INF;
+        }
+        return std::min(PN_INF - 1, sum + value);
+    }
+
+    template <Color color>
+    pn_value mid(board & chessboard, int moves, bool attacker, std::uint32_t th_phi, std::uint32_t th_delta, int ply) {
+        constexpr Color enemy = color == White ? Black : White;
+
+        if ((++node_count & 1023) == 0 && (stop_flag->load(std::memory_order_relaxed) || node_count >= node_limit)) {
+            aborted = true;
+        }
+
+        // a root that tries only its share of the moves is stored apart from the same position searched with all of them,
+        // a disproof of the share says nothing about the position
+        std::uint64_t key = node_key(chessboard.get_hash_key(), moves);
+        if (ply == 0 && root_stride > 1) {
+            key = node_key(key, static_cast<int>(root_stride * 256 + root_offset));
+        }
+
+        pn_value value;
+        if (lookup(key, value) && (value.phi >= th_phi || value.delta >= th_delta)) {
+            return value;
+        }
+
+        stack_move_list list;
+        generate_all_moves<color>(chessboard, list);
+
+        // the attacker loses without moves and both sides lose to the mate, a defender that can still move has escaped
+        if (list.size() == 0 || moves == 0) {
+            const bool lost = list.size() == 0 ? attacker || chessboard.in_check() : attacker;
+            value = lost ? pn_value{PN_INF, 0} : pn_value{0, PN_INF};
+            store(key, value);
+            return value;
+        }
+
+        // children after each move, with the last move only a check can mate
+        const int child_moves = attacker ? moves - 1 : moves;
+        std::array<chess_move, 256> child_move;
+        std::array<std::uint64_t, 256> child_key;
+        std::array<pn_value, 256> child_value;
+        int children = 0;
+
+        for (int i = 0; i < list.size(); i++) {
+            const chess_move move = list.get_move(i);
+            if ((ply == 0 && i % root_stride != root_offset) || (attacker && moves == 1 && !chessboard.gives_check<color>(move))) {
+                continue;
+            }
+
+            make_move<color, false>(chessboard, move);
+            child_move[children] = move;
+            child_key[children] = node_key(chessboard.get_hash_key(), child_moves);
+            undo_move<color, false>(chessboard, move);
+
+            child_value[children] = {};
+            lookup(child_key[children], child_value[children]);
+            children++;
+        }
+
+        if (children == 0) {
+            value = {PN_INF, 0};
+            store(key, value);
+            return value;
+        }
+
+        while (true) {
+            int best = 0;
+            std::uint32_t second_delta = PN_INF;
+            value = {PN_INF, 0};
+
+            for (int i = 0; i < children; i++) {
+                lookup(child_key[i], child_value[i]);
+                value.delta = add(value.delta, child_value[i].phi);
+
+                if (i > 0 && child_value[i].delta < child_value[best].delta) {
+                    second_delta = child_value[best].delta;
+                    best = i;
+                } else if (i > 0 && child_value[i].delta < second_delta) {
+                    second_delta = child_value[i].delta;
+                }
+            }
+            value.phi = child_value[best].delta;
+            if (ply == 0 && value.phi == 0) {
+                proved_root_move = child_move[best];
+            }
+
+            if (value.phi >= th_phi || value.delta >= th_delta || aborted) {
+                store(key, value);
+                return value;
+            }
+
+            const std::uint32_t child_th_phi = std::min<std::uint64_t>(PN_INF, std::uint64_t{th_delta} - value.delta + child_value[best].phi);
+            const std::uint32_t child_th_delta = std::min(th_phi, second_delta == PN_INF ? PN_INF : second_delta + 1);
+
+            make_move<color, false>(chessboard, child_move[best]);
+            child_value[best] = mid<enemy>(chessboard, child_moves, !attacker, child_th_phi, child_th_delta, ply + 1);
+            undo_move<color, false>(chessboard, child_move[best]);
+        }
+    }
+
+    // the attacker plays a move to a lost node, the defender any move as all of them lose
+    template <Color color>
+    void collect_pv(board & chessboard, int moves, bool attacker, std::vector<chess_move> & pv) {
+        constexpr Color enemy = color == White ? Black : White;
+        if (moves == 0 && attacker) {
+            return;
+        }
+
+        stack_move_list list;
+        generate_all_moves<color>(chessboard, list);
+        const int child_moves = attacker ? moves - 1 : moves;
+
+        for (const chess_move & move : list) {
+            make_move<color, false>(chessboard, move);
+            pn_value value;
+            const bool found = lookup(node_key(chessboard.get_hash_key(), child_moves), value);
+
+            if (found && (attacker ? value.delta == 0 : value.phi == 0)) {
+                pv.push_back(move);
+                collect_pv<enemy>(chessboard, child_moves, !attacker, pv);
+                undo_move<color, false>(chessboard, move);
+                return;
+            }
+            undo_move<color, false>(chessboard, move);
+        }
+    }
+};
+
+// Runs the provers of all threads on the root moves split between them, for mates of one move up to the limit, so the
+// first mate found is the shortest one. The tables are kept between searches, their entries do not depend on the root.
+class mate_search {
+public:
+    // prints the mate and returns true if one is found, false when there is none or the node budget ran out
+    bool run(board & chessboard, int max_moves, unsigned int threads, std::uint64_t max_nodes) {
+        threads = std::max(1u, threads);
+        if (provers.size() != threads) {
+            provers.clear();
+            for (unsigned int i = 0; i < threads; i++) {
+                provers.push_back(std::make_unique<mate_prover>(table_clusters / threads));
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::uint64_t total_nodes = 0;
+
+        for (int moves = 1; moves <= max_moves; moves++) {
+            std::atomic<bool> stop = false;
+            std::atomic<int> winner = -1;
+            std::vector<board> boards(threads, chessboard);
+            std::vector<std::thread> workers;
+
+            for (unsigned int i = 0; i < threads; i++) {
+                workers.emplace_back([&, i] {
+                    if (provers[i]->prove(boards[i], moves, stop, max_nodes / threads, i, threads)) {
+                        int none = -1;
+                        winner.compare_exchange_strong(none, static_cast<int>(i));
+                        stop = true;
+                    }
+                });
+            }
+
+            bool aborted = false;
+            for (unsigned int i = 0; i < threads; i++) {
+                workers[i].join();
+                total_nodes += provers[i]->nodes();
+                aborted = aborted || (provers[i]->was_aborted() && winner < 0);
+            }
+
+            if (winner >= 0) {
+                const std::vector<chess_move> pv = provers[winner]->principal_variation(boards[winner], moves);
+                const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+                // the root move is kept by the prover, the rest of the line may have been overwritten in the table
+                const chess_move best_move = pv.empty() ? provers[winner]->root_move() : pv.front();
+                std::string pv_string;
+                for (const chess_move & move : pv) {
+                    pv_string += move.to_string() + " ";
+                }
+                if (pv.empty()) {
+                    pv_string = best_move.to_string();
+                }
+
+                std::cout << "info depth " << 2 * moves - 1 << " score mate " << moves << " nodes " << total_nodes
+                          << " nps " << total_nodes * 1000 / std::max<std::int64_t>(1, elapsed) << " pv " << pv_string << std::endl;
+                std::cout << "bestmove " << best_move.to_string() << "\n";
+                return true;
+            }
+
+            if (aborted) {
+                break;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    static constexpr std::size_t table_clusters = 1 << 20; // 64 MB
+    std::vector<std::unique_ptr<mate_prover>> provers;
+};
+
+mate_search mate_finder;
+
+#endif //MOTOR_MATE_SEARCH_HPP
@@ -22,20 +22,33 @@ constexpr int noisy_base = -409;
 constexpr int mvv[7] = { 500, 1000, 1000, 2000, 3000, 0, 1044 };
 
 template <Color color>
-void score_moves(board & chessboard, move_list & movelist, search_data & data, const chess_move & tt_move) {
+void score_moves(board & chessboard, move_list & movelist, search_data & data, see_context & see_ctx, const chess_move & tt_move) {
+    PROFILE_SECTION(Move_Ordering);
+    // the capture history sets the SEE threshold of each capture, all of them are then exchanged in one sweep
+    std::array<int, 256> see_thresholds;
     int move_index = 0;
-    for (chess_move & move : movelist) {
-        const Square from = move.get_from();
-        const Square to   = move.get_to();
+    for (const extended_move & move : movelist) {
+        if (!move.is_quiet()) {
+            const int cap_score = history->get_capture_score<color>(chessboard, move.get_piece(), move.get_to(), move.get_captured());
+            movelist[move_index] = cap_score;
+            see_thresholds[move_index] = -cap_score / 40;
+        }
+        move_index++;
+    }
+
+    const move_subset good_captures = see_ctx.see_all<color>(movelist, see_thresholds);
+
+    move_index = 0;
+    for (const extended_move & move : movelist) {
         int move_score;
         if (move == tt_move) {
             move_score = 214748364;
-        } else if (!chessboard.is_quiet(move)) {
-            int cap_score = history->get_capture_score<color>(chessboard, chessboard.get_piece(from), to, chessboard.get_piece(to));
-            move_score = 10'000'000 * see<color>(chessboard, move, -cap_score / 40) + mvv[chessboard.get_piece(to)];
+        } else if (!move.is_quiet()) {
+            const int cap_score = movelist.get_move_score(move_index);
+            move_score = 10'000'000 * good_captures.contains(move_index) + mvv[move.get_captured()];
             move_score += cap_score;
         } else {
-            move_score = history->get_quiet_score<color>(chessboard, data, from, to, chessboard.get_piece(from));
+            move_score = history->get_quiet_score<color>(chessboard, data, move.get_from(), move.get_to(), move.get_piece());
             move_score += 32'000 * (data.get_killer() == move);
         }
         
@@ -44,12 +57,30 @@ void score_moves(board & chessboard, move_list & movelist, search_data & data, c
     }
 }
 
-void qs_score_moves(board & chessboard, move_list & movelist) {
+// root moves the search before scored go ahead of the rest, in the order of their scores
+constexpr int ROOT_SEED_SCORE = 100'000'000;
+
+void score_root_moves(move_list & movelist, const root_seed & seed, const chess_move & tt_move) {
+    int move_index = 0;
+    for (const extended_move & move : movelist) {
+        const int previous = seed.scores[move.get_from()][move.get_to()];
+        if (!(move == tt_move) && previous != NO_ROOT_SCORE) {
+            movelist[move_index] = ROOT_SEED_SCORE + previous;
+        }
+        move_index++;
+    }
+}
+
+// whether the ordering score is one of score_root_moves, the scores of the search before are within int16
+constexpr bool is_seeded_root_score(int move_score) {
+    return move_score >= ROOT_SEED_SCORE + INT16_MIN && move_score <= ROOT_SEED_SCORE + INT16_MAX;
+}
+
+void qs_score_moves(move_list & movelist) {
+    PROFILE_SECTION(Move_Ordering);
     int move_index = 0;
-    for(chess_move & move : movelist) {
-        const std::uint8_t from = move.get_from();
-        const std::uint8_t to   = move.get_to();
-        movelist[move_index] = mvv_lva[chessboard.get_piece(to)][chessboard.get_piece(from)];
+    for(const extended_move & move : movelist) {
+        movelist[move_index] = mvv_lva[move.get_captured()][move.get_piece()];
         move_index++;
     }
 }
@@ -3,82 +3,167 @@
 
 #include <cstdint>
 #include "../../chess_board/board.hpp"
+#include "../../move_generation/move_list.hpp"
+#include "../../profiler.hpp"
 
 constexpr std::int32_t SEE_VALUES[7] = { 100, 300, 300, 500, 900, 0, 0 };
 
-template <Color color>
-static bool see(board& chessboard, const chess_move& chessmove, int threshold = 0) {
-    Square from = chessmove.get_from();
-    Square to = chessmove.get_to();
-
-    int balance = -threshold;
+// Static exchange evaluation of the moves of one node. The sliders, the side occupancies and, per target square, the
+// attackers and the x-ray attackers are computed once and shared by every exchange, so the context should live as
+// long as the node.
+class see_context {
+public:
+    explicit see_context(const board & chessboard)
+            : chessboard(chessboard), cached_squares(0ull),
+              occupancy(chessboard.get_occupancy()),
+              bishops(chessboard.get_diagonal_pieces<White>() | chessboard.get_diagonal_pieces<Black>()),
+              rooks(chessboard.get_orthogonal_pieces<White>() | chessboard.get_orthogonal_pieces<Black>()),
+              side_occupancy{chessboard.get_side_occupancy<White>(), chessboard.get_side_occupancy<Black>()} {}
 
-    Piece captured_piece = chessmove.get_move_type() == EN_PASSANT ? Pawn : chessboard.get_piece(to);
-    balance += SEE_VALUES[captured_piece];
-    if (balance < 0) {
-        return false;
+    template <Color color>
+    bool see(const chess_move& chessmove, int threshold = 0) {
+        PROFILE_SECTION(See);
+        return exchange<color>(chessmove, threshold);
     }
 
-    balance -= SEE_VALUES[chessboard.get_piece(from)];
-    if (balance >= 0) {
-        return true;
+    // SEE of the captures and promotions of the list in one sweep, the positions of the moves that reach the
+    // threshold of their index, quiet moves are never included
+    template <Color color>
+    move_subset see_all(const move_list & movelist, const std::array<int, 256> & thresholds) {
+        PROFILE_SECTION(See);
+        move_subset passed;
+        std::uint8_t move_index = 0;
+        for (const extended_move & move : movelist) {
+            if (!move.is_quiet() && exchange<color>(move, thresholds[move_index])) {
+                passed.insert(move_index);
+            }
+            move_index++;
+        }
+        return passed;
     }
 
-    int side_to_capture = 1 - color;
+private:
+    const board & chessboard;
+    std::uint64_t cached_squares;
+    const std::uint64_t occupancy;
+    const std::uint64_t bishops;
+    const std::uint64_t rooks;
+    const std::uint64_t side_occupancy[2];
+    std::array<std::uint64_t, 64> attackers;
+    std::array<std::uint64_t, 64> xrays;
 
-    const std::uint64_t queens = chessboard.get_pieces(White, Queen) | chessboard.get_pieces(Black, Queen);
-    const std::uint64_t rooks = chessboard.get_pieces(White, Rook) | chessboard.get_pieces(Black, Rook) | queens;
-    const std::uint64_t bishops = chessboard.get_pieces(White, Bishop) | chessboard.get_pieces(Black, Bishop) | queens;
+    template <Color color>
+    bool exchange(const chess_move& chessmove, int threshold) {
+        const Square from = chessmove.get_from();
+        const Square to = chessmove.get_to();
 
-    std::uint64_t occupancy = chessboard.get_occupancy() ^ (1ull << from) ^ (1ull << to);
+        int balance = -threshold;
 
-    std::uint64_t attackers = chessboard.attackers<White>(to, occupancy) | chessboard.attackers<Black>(to, occupancy);
+        Piece captured_piece = chessmove.get_move_type() == EN_PASSANT ? Pawn : chessboard.get_piece(to);
+        balance += SEE_VALUES[captured_piece];
+        if (balance < 0) {
+            return false;
+        }
 
-    std::uint64_t side_occupancy[2] = { chessboard.get_side_occupancy<White>(), chessboard.get_side_occupancy<Black>() };
+        balance -= SEE_VALUES[chessboard.get_piece(from)];
+        if (balance >= 0) {
+            return true;
+        }
 
-    Piece piece;
-    while (true) {
-        attackers &= occupancy;
+        int side_to_capture = 1 - color;
 
-        //attackers &= side_occupancy[side_to_capture];
-        if ((attackers & side_occupancy[side_to_capture]) == 0ull) {
-            break;
-        }
+        std::uint64_t exchange_occupancy = occupancy ^ bb(from) ^ bb(to);
+        std::uint64_t square_attackers = attackers_to(to) | discovered_by(from, to);
 
-        for (Piece pt : {Pawn, Knight, Bishop, Rook, Queen, King}) {
-            std::uint64_t bitboard = attackers & chessboard.get_pieces(side_to_capture, pt);
-            if (bitboard) {
-                occupancy ^= (1ull << lsb(bitboard));
-                piece = pt;
+        Piece piece = Null_Piece;
+        while (true) {
+            square_attackers &= exchange_occupancy;
+
+            const std::uint64_t our_attackers = square_attackers & side_occupancy[side_to_capture];
+            if (our_attackers == 0ull) {
                 break;
             }
-        }
 
-        balance = -balance - 1 - SEE_VALUES[piece];
+            for (Piece pt : {Pawn, Knight, Bishop, Rook, Queen, King}) {
+                std::uint64_t bitboard = our_attackers & chessboard.get_pieces(side_to_capture, pt);
+                if (bitboard) {
+                    exchange_occupancy ^= bb(lsb(bitboard));
+                    piece = pt;
+                    break;
+                }
+            }
+
+            balance = -balance - 1 - SEE_VALUES[piece];
 
-        side_to_capture = 1 - side_to_capture;
+            side_to_capture = 1 - side_to_capture;
 
-        if (balance >= 0) {
-            if (piece == King && (attackers & side_occupancy[side_to_capture])) {
-                side_to_capture = 1 - side_to_capture;
+            if (balance >= 0) {
+                if (piece == King && (square_attackers & side_occupancy[side_to_capture])) {
+                    side_to_capture = 1 - side_to_capture;
+                }
+                break;
             }
-            break;
-        }
 
+            if (piece == Pawn || piece == Bishop || piece == Queen) {
+                square_attackers |= (attacks<Ray::BISHOP>(to, exchange_occupancy) & bishops);
+            }
 
-        if (piece == Pawn || piece == Bishop || piece == Queen) {
-            attackers |= (attacks<Ray::BISHOP>(to, occupancy) & bishops);
+            if (piece == Rook || piece == Queen) {
+                square_attackers |= (attacks<Ray::ROOK>(to, exchange_occupancy) & rooks);
+            }
         }
 
-        if (piece == Rook || piece == Queen) {
-            attackers |= (attacks<Ray::ROOK>(to, occupancy) & rooks);
+        return color != side_to_capture;
+    }
+
+    // the slider behind the moving piece, the x-ray attackers of the square see it through exactly one man, so the
+    // one with from between itself and the square is the one that the move uncovers
+    std::uint64_t discovered_by(const Square from, const Square to) {
+        std::uint64_t discovered = 0ull;
+        for (std::uint64_t candidates = xray_attackers_to(to); candidates;) {
+            const Square slider = pop_lsb(candidates);
+            if (pinmask[to][slider] & bb(from)) {
+                discovered |= bb(slider);
+            }
         }
+        return discovered;
     }
 
-    return color != side_to_capture;
-}
+    // attackers of both colors with the full occupancy of the position
+    std::uint64_t attackers_to(const Square square) {
+        cache_square(square);
+        return attackers[square];
+    }
 
+    // sliders of both colors that attack the square through one man
+    std::uint64_t xray_attackers_to(const Square square) {
+        cache_square(square);
+        return xrays[square];
+    }
+
+    void cache_square(const Square square) {
+        if (cached_squares & bb(square)) {
+            return;
+        }
 
+        const std::uint64_t rook_attacks = attacks<Ray::ROOK>(square, occupancy);
+        const std::uint64_t bishop_attacks = attacks<Ray::BISHOP>(square, occupancy);
+        attackers[square] = (rook_attacks & rooks)
+                          | (bishop_attacks & bishops)
+                          | (KING_ATTACKS[square] & (chessboard.get_pieces(White, King) | chessboard.get_pieces(Black, King)))
+                          | (KNIGHT_ATTACKS[square] & (chessboard.get_pieces(White, Knight) | chessboard.get_pieces(Black, Knight)))
+                          | (PAWN_ATTACKS_TABLE[White][square] & chessboard.get_pieces(Black, Pawn))
+                          | (PAWN_ATTACKS_TABLE[Black][square] & chessboard.get_pieces(White, Pawn));
+        xrays[square] = ((attacks<Ray::ROOK>(square, occupancy ^ (rook_attacks & occupancy)) & ~rook_attacks & rooks)
+                       | (attacks<Ray::BISHOP>(square, occupancy ^ (bishop_attacks & occupancy)) & ~bishop_attacks & bishops));
+        cached_squares |= bb(square);
+    }
+};
+
+template <Color color>
+static bool see(const board& chessboard, const chess_move& chessmove, int threshold = 0) {
+    return see_context(chessboard).see<color>(chessmove, threshold);
+}
 
 void see_test_suite() {
     auto convertValue = [](int value) { return value >= 0; };
@@ -147,7 +232,7 @@ void see_test_suite() {
     std::vector<std::string> errors;
     for (auto [fen, move_string, value, good_capture] : see_data) {
         board b(fen);
-        move_list ml;
+        stack_move_list ml;
         if (b.get_side() == White) {
             generate_all_moves<White, false>(b, ml);
         }
@@ -0,0 +1,140 @@
+#ifndef MOTOR_PERF_COUNTERS_HPP
+#define MOTOR_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class Counter : std::uint8_t {
+    Cycles, Instructions, L1D_Misses, LLC_Misses, DTLB_Misses, Branch_Misses, Count
+};
+
+constexpr std::array<const char *, static_cast<int>(Counter::Count)> counter_names = {
+    "cycles", "instructions", "l1d-misses", "llc-misses", "dtlb-misses", "branch-misses"
+};
+
+using counter_values = std::array<double, static_cast<int>(Counter::Count)>;
+
+// Hardware counters of this thread from perf_event_open, counting user space only so that the default
+// perf_event_paranoid setting allows them. Every counter is opened on its own, so the ones the CPU or the kernel does
+// not have are left out and the rest still count. Values are scaled up when the kernel had to multiplex the counters.
+class perf_counters {
+public:
+    perf_counters() {
+        descriptors.fill(-1);
+#ifdef __linux__
+        constexpr auto cache_miss = [](std::uint64_t cache) {
+            return cache | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+        };
+        const std::array<std::pair<std::uint32_t, std::uint64_t>, static_cast<int>(Counter::Count)> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D)},
+            {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL)},
+            {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_DTLB)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+
+        for (std::size_t i = 0; i < events.size(); i++) {
+            perf_event_attr attributes = {};
+            attributes.size = sizeof(attributes);
+            attributes.type = events[i].first;
+            attributes.config = events[i].second;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            descriptors[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+            if (descriptors[i] < 0 && error.empty()) {
+                error = std::strerror(errno);
+            }
+        }
+#else
+        error = "only on linux";
+#endif
+    }
+
+    ~perf_counters() {
+#ifdef __linux__
+        for (const int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters & operator=(const perf_counters &) = delete;
+
+    [[nodiscard]] bool available(Counter counter) const {
+        return descriptors[static_cast<int>(counter)] >= 0;
+    }
+
+    [[nodiscard]] bool any_available() const {
+        for (const int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // why the first counter that failed could not be opened
+    [[nodiscard]] const std::string & open_error() const {
+        return error;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (const int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (const int descriptor : descriptors) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // counts since start, zero for the counters that are not available
+    [[nodiscard]] counter_values read() const {
+        counter_values values = {};
+#ifdef __linux__
+        for (std::size_t i = 0; i < descriptors.size(); i++) {
+            std::uint64_t data[3] = {}; // value, time enabled, time running
+            if (descriptors[i] < 0 || ::read(descriptors[i], data, sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            values[i] = data[2] ? double(data[0]) * double(data[1]) / double(data[2]) : 0.0;
+        }
+#endif
+        return values;
+    }
+
+private:
+    std::array<int, static_cast<int>(Counter::Count)> descriptors = {};
+    std::string error;
+};
+
+#endif //MOTOR_PERF_COUNTERS_HPP
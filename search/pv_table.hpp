@@ -32,6 +32,14 @@ public:
         return triangular_pv_table[0][0];
     }
 
+    [[nodiscard]] int get_length() const {
+        return pv_length[0];
+    }
+
+    [[nodiscard]] chess_move get_move(int index) const {
+        return triangular_pv_table[0][index];
+    }
+
     void set_length(std::uint8_t length) {
         pv_length[length] = length;
     }
@@ -21,10 +21,19 @@ std::int16_t quiescence_search(board & chessboard, search_data & data, std::int1
         return evaluate<color>(chessboard);
     }
 
-    if (chessboard.is_draw(data.get_ply())) {
+    SEARCH_STAT(data.stats.qsearch_nodes++);
+
+    if (chessboard.is_draw(data.get_ply()) || material_cache.probe(chessboard).is_draw()) {
         return 0;
     }
 
+    if (alpha < 0 && chessboard.upcoming_repetition(data.get_ply())) {
+        alpha = 0;
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
     bool in_check = chessboard.in_check();
     std::int16_t static_eval, eval;
 
@@ -32,6 +41,7 @@ std::int16_t quiescence_search(board & chessboard, search_data & data, std::int1
 
     std::uint64_t zobrist_key = chessboard.get_hash_key();
     const TT_entry& tt_entry = tt.retrieve(zobrist_key, data.get_ply());
+    SEARCH_STAT(data.stats.tt_probe(STAT_NODE_TYPES - 1, tt_entry.zobrist == tt.upper(zobrist_key)));
     chess_move tt_move = {};
 
     if (tt_entry.zobrist == tt.upper(zobrist_key)) {
@@ -42,6 +52,7 @@ std::int16_t quiescence_search(board & chessboard, search_data & data, std::int1
         if ((tt_entry.bound == Bound::EXACT) ||
             (tt_entry.bound == Bound::LOWER && tt_eval >= beta) ||
             (tt_entry.bound == Bound::UPPER && tt_eval <= alpha)) {
+            SEARCH_STAT(data.stats.tt_cutoffs[STAT_NODE_TYPES - 1]++);
             return tt_eval;
         }
 
@@ -62,43 +73,47 @@ std::int16_t quiescence_search(board & chessboard, search_data & data, std::int1
         alpha = eval;
     }
 
-    move_list movelist;
+    arena_move_list movelist(data.arena);
+    see_context see_ctx(chessboard);
     if (in_check) {
         generate_all_moves<color, false>(chessboard, movelist);
-        score_moves<color>(chessboard, movelist, data, tt_move);
+        score_moves<color>(chessboard, movelist, data, see_ctx, tt_move);
         if (movelist.size() == 0) {
             return data.mate_value();
         }
     } else {
         generate_all_moves<color, true>(chessboard, movelist);
-        qs_score_moves(chessboard, movelist);
+        qs_score_moves(movelist);
     }
+    movelist.commit();
 
     std::int16_t futility_base = eval + 250;
 
     chess_move best_move;
 
     for (std::uint8_t moves_searched = 0; moves_searched < movelist.size(); moves_searched++) {
-        chess_move & chessmove = movelist.get_next_move(moves_searched);
+        extended_move & chessmove = movelist.get_next_move(moves_searched);
 
         if (in_check && movelist.get_move_score(moves_searched) < 16'000 && moves_searched) {
             break;
         }
 
         if (!in_check) {
-            if (chessboard.is_capture(chessmove) && futility_base <= alpha && !see<color>(chessboard, chessmove, 1)) {
+            if (chessmove.is_capture() && futility_base <= alpha && !see_ctx.see<color>(chessmove, 1)) {
                 eval = std::max(eval, futility_base);
                 continue;
             }
 
-            if (!see<color>(chessboard, chessmove)) {
+            if (!see_ctx.see<color>(chessmove)) {
                 continue;
             }
         }
 
+        tt.prefetch(chessboard.key_after<color>(chessmove));
+        prefetch_move<color>(chessboard, chessmove);
         make_move<color>(chessboard, chessmove);
         data.augment_ply();
-        tt.prefetch(chessboard.get_hash_key());
+        history->prefetch_correction(chessboard, data);
         std::int16_t score = -quiescence_search<enemy_color>(chessboard, data, -beta, -alpha, depth - 1);
         undo_move<color>(chessboard, chessmove);
         data.reduce_ply();
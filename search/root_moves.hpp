@@ -0,0 +1,71 @@
+#ifndef MOTOR_ROOT_MOVES_HPP
+#define MOTOR_ROOT_MOVES_HPP
+
+#include <array>
+#include <climits>
+#include <cstdint>
+
+#include "../chess_board/chess_move.hpp"
+
+// indexed by [from][to] of a root move
+template <typename T>
+using root_table = std::array<std::array<T, 64>, 64>;
+
+constexpr int NO_ROOT_SCORE = INT_MIN;
+
+// what a search starts with from the one before it
+struct root_seed {
+    root_seed() {
+        for (auto & row : scores) {
+            row.fill(NO_ROOT_SCORE);
+        }
+    }
+
+    chess_move best_move = {};
+    root_table<int> scores;
+    root_table<int> node_count = {};
+    std::uint64_t nodes = 0;
+};
+
+// The root moves of the last search, for the next one. When the same position is searched again the scores and node
+// counts of all root moves carry over, when the game went on with the best move and the reply the principal variation
+// expected only the move the variation continues with is known.
+class root_move_cache {
+public:
+    void save(std::uint64_t root_key, const root_seed & root, std::uint64_t next_key, chess_move next_move) {
+        key = root_key;
+        last = root;
+        expected_key = next_key;
+        expected_move = next_move;
+    }
+
+    // false when the position is neither the last root nor the expected continuation
+    [[nodiscard]] bool seed(std::uint64_t root_key, root_seed & seed) const {
+        if (root_key == key && last.best_move.get_value()) {
+            seed = last;
+            return true;
+        }
+        if (root_key == expected_key && expected_move.get_value()) {
+            seed = {};
+            seed.best_move = expected_move;
+            return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        key = expected_key = 0;
+        last = {};
+        expected_move = {};
+    }
+
+private:
+    std::uint64_t key = 0;
+    root_seed last;
+    std::uint64_t expected_key = 0;
+    chess_move expected_move = {};
+};
+
+root_move_cache root_moves;
+
+#endif //MOTOR_ROOT_MOVES_HPP
@@ -13,6 +13,8 @@
 #include "../move_generation/move_list.hpp"
 #include "../move_generation/move_generator.hpp"
 #include "../executioner/makemove.hpp"
+#include "../tablebase/tablebase.hpp"
+#include "../book/opening_book.hpp"
 
 constexpr int iir_depth = 4;
 constexpr int razoring = 500;
@@ -42,6 +44,9 @@ constexpr int asp_window_mul = 15;
 constexpr int asp_window_max = 650;
 constexpr int asp_depth = 8;
 
+// a move that is the only legal one is played after this depth when playing on a clock
+constexpr int forced_move_depth = 4;
+
 template <Color color, NodeType node_type>
 std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha, std::int16_t beta, std::int8_t depth, bool cutnode) {
     constexpr Color enemy_color = color == White ? Black : White;
@@ -56,6 +61,7 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
         return evaluate<color>(chessboard);
     }
 
+    SEARCH_STAT(data.stats.main_nodes++);
     data.update_pv_length();
 
     bool in_check = false;
@@ -66,10 +72,29 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
             return alpha;
         }
 
-        if (chessboard.is_draw(data.get_ply())) {
+        if (chessboard.is_draw(data.get_ply()) || material_cache.probe(chessboard).is_draw()) {
             return 0;
         }
 
+        if (alpha < 0 && chessboard.upcoming_repetition(data.get_ply())) {
+            alpha = 0;
+            if (alpha >= beta) {
+                return alpha;
+            }
+        }
+
+        // inside the tables of the root only a capture or a pawn move is probed, the search and the evaluation have to
+        // find the way to the mate in between
+        if (data.stack()->excluded_move == 0 && (!data.is_tablebase_root() || chessboard.get_fifty_move_clock() == 0)) {
+            const WDL wdl = tablebases.probe_wdl(chessboard);
+            const std::int16_t tb_score = wdl == WDL::WIN  ? TB_WIN - data.get_ply()
+                                        : wdl == WDL::LOSS ? -TB_WIN + data.get_ply() : 0;
+
+            if (wdl == WDL::DRAW || (wdl == WDL::WIN && tb_score >= beta) || (wdl == WDL::LOSS && tb_score <= alpha)) {
+                return tb_score;
+            }
+        }
+
         in_check = chessboard.in_check();
     }
 
@@ -78,9 +103,12 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
     }
 
     Bound flag = Bound::UPPER;
+    see_context see_ctx(chessboard);
+    search_stack * ss = data.stack();
 
     std::uint64_t zobrist_key = chessboard.get_hash_key();
     const TT_entry& tt_entry = tt.retrieve(zobrist_key, data.get_ply());
+    SEARCH_STAT(data.stats.tt_probe(static_cast<int>(node_type), tt_entry.zobrist == tt.upper(zobrist_key)));
 
     chess_move best_move;
     chess_move tt_move = {};
@@ -106,10 +134,11 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
             }
         }
 
-        if (would_tt_prune && data.singular_move[data.get_ply()] == 0) {
+        if (would_tt_prune && ss->excluded_move == 0) {
             if (is_pv) {
                 depth --;
             } else {
+                SEARCH_STAT(data.stats.tt_cutoffs[static_cast<int>(node_type)]++);
                 return tt_eval;
             }
         }
@@ -121,32 +150,35 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
     } else {
         raw_eval = in_check ? -INF : evaluate<color>(chessboard);
         eval = static_eval = history->correct_eval<color>(chessboard, data, raw_eval);
-        if (data.singular_move[data.get_ply()] == 0 && depth >= iir_depth) {
+        if (ss->excluded_move == 0 && depth >= iir_depth) {
             depth--;
         }
     }
 
     int correction = in_check ? 0 : static_eval - raw_eval;
 
-    data.improving[data.get_ply()] = static_eval;
-    int improving = !in_check && data.get_ply() > 1 && static_eval > data.improving[data.get_ply() - 2];
+    ss->static_eval = static_eval;
+    int improving = !in_check && static_eval > ss[-2].static_eval;
 
-    data.prev_moves[data.get_ply()] = {};
+    ss->move = {};
+    ss->continuation = history->continuation(ss->move);
     data.reset_killers();
-    data.singular_move[data.get_ply() + 1] = {};
+    ss[1].excluded_move = 0;
 
     if constexpr (!is_root) {
-        if (data.singular_move[data.get_ply()] == 0 && !in_check && std::abs(beta) < 9'000) {
+        if (ss->excluded_move == 0 && !in_check && std::abs(beta) < 9'000) {
             // razoring
             if (depth < razoring_depth && eval + razoring * depth <= alpha) {
                 std::int16_t razor_eval = quiescence_search<color>(chessboard, data, alpha, beta);
                 if (razor_eval <= alpha) {
+                    SEARCH_STAT(data.stats.prune(Prune::Razoring));
                     return razor_eval;
                 }
             }
 
             // reverse futility pruning
             if (depth < rfp_depth && eval - (rfp - 48 * !is_pv) * (depth - improving) >= beta) {
+                SEARCH_STAT(data.stats.prune(Prune::Reverse_Futility));
                 return (eval + beta) / 2;
             }
 
@@ -160,6 +192,7 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
                 data.reduce_ply();
                 chessboard.undo_null_move<color>();
                 if (nullmove_score >= beta) {
+                    SEARCH_STAT(data.stats.prune(Prune::Null_Move));
                     return std::abs(nullmove_score) > 19'000 ? beta : nullmove_score;
                 }
             }
@@ -167,20 +200,23 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
             const auto probcut_beta = beta + 214;
             if (depth >= 5 && !(tt_move.get_value() && tt_entry.depth > depth - 3 && tt_entry.score < probcut_beta)) {
                 const auto see_treshold = probcut_beta - static_eval;
-                move_list movelist;
+                arena_move_list movelist(data.arena);
                 generate_all_moves<color, true>(chessboard, movelist);
-                qs_score_moves(chessboard, movelist);
+                movelist.commit();
+                qs_score_moves(movelist);
 
                 for (std::uint8_t moves_searched = 0; moves_searched < movelist.size(); moves_searched++) {
-                    chess_move &chessmove = movelist.get_next_move(moves_searched);
+                    extended_move &chessmove = movelist.get_next_move(moves_searched);
 
-                    if (!see<color>(chessboard, chessmove, see_treshold)) {
+                    if (!see_ctx.see<color>(chessmove, see_treshold)) {
                         continue;
                     }
 
+                    tt.prefetch(chessboard.key_after<color>(chessmove));
+                    prefetch_move<color>(chessboard, chessmove);
                     make_move<color>(chessboard, chessmove);
                     data.augment_ply();
-                    tt.prefetch(chessboard.get_hash_key());
+                    history->prefetch_correction(chessboard, data);
                     std::int16_t score = -quiescence_search<enemy_color>(chessboard, data, -probcut_beta,-probcut_beta + 1);
 
                     if (score >= probcut_beta) {
@@ -191,6 +227,7 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
                     data.reduce_ply();
 
                     if (score >= probcut_beta) {
+                        SEARCH_STAT(data.stats.prune(Prune::Probcut));
                         tt.store(Bound::LOWER, std::int8_t(depth - 3), score, raw_eval, chessmove, data.get_ply(), tt_pv, zobrist_key);
                         return score;
                     }
@@ -199,11 +236,13 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
         }
     }
 
-    move_list movelist, quiets, captures;
+    arena_move_list movelist(data.arena);
     generate_all_moves<color, false>(chessboard, movelist);
+    movelist.commit();
+    move_subset quiets, captures;
 
     if (movelist.size() == 0) {
-        if (data.singular_move[data.get_ply()] > 0) return alpha;
+        if (ss->excluded_move > 0) return alpha;
         if (in_check) {
             return data.mate_value();
         } else {
@@ -212,36 +251,47 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
     }
 
     std::int16_t best_score = -INF;
-    score_moves<color>(chessboard, movelist, data, best_move);
+    if constexpr (is_root) {
+        if (best_move.get_value() == 0) {
+            best_move = data.get_root_seed().best_move;
+        }
+    }
+    score_moves<color>(chessboard, movelist, data, see_ctx, best_move);
+    if constexpr (is_root) {
+        score_root_moves(movelist, data.get_root_seed(), best_move);
+    }
 
     for (std::uint8_t moves_searched = 0; moves_searched < movelist.size(); moves_searched++) {
-        chess_move& chessmove = movelist.get_next_move(moves_searched);
+        extended_move& chessmove = movelist.get_next_move(moves_searched);
 
-        if (chessmove.get_value() == data.singular_move[data.get_ply()]) {
+        if (chessmove.get_value() == ss->excluded_move) {
             continue;
         }
 
         std::uint64_t start_nodes = data.get_nodes();
 
         int reduction = lmr_table[depth][moves_searched];
-        bool is_quiet = chessboard.is_quiet(chessmove);
+        bool is_quiet = chessmove.is_quiet();
 
         if constexpr (!is_root) {
             if (moves_searched && best_score > -9'000 && !in_check && movelist[moves_searched] < 20'000) {
                 if (is_quiet) {
                     if (quiets.size() > lmp_base + depth * depth / (2 - improving)) {
+                        SEARCH_STAT(data.stats.prune(Prune::Late_Move));
                         break;
                     }
 
                     int lmr_depth = std::max(0, depth - reduction - !improving + movelist.get_move_score(moves_searched) / 6000);
                     if (lmr_depth < fp_depth && static_eval + fp_base + fp_mul * lmr_depth <= alpha) {
+                        SEARCH_STAT(data.stats.prune(Prune::Futility));
                         break;
                     }
                 }
 
 
                 int see_margin = is_quiet ? -see_quiet * depth : -see_noisy * depth * depth;
-                if (depth <= 6 + is_quiet * 4 && !see<color>(chessboard, chessmove, see_margin)) {
+                if (depth <= 6 + is_quiet * 4 && !see_ctx.see<color>(chessmove, see_margin)) {
+                    SEARCH_STAT(data.stats.prune(Prune::See));
                     continue;
                 }
             }
@@ -255,17 +305,17 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
                 movelist.get_move_score(moves_searched) == 214'748'364 &&
                 tt_entry.depth >= depth - se_depth_margin &&
                 tt_entry.bound != Bound::UPPER &&
-                data.singular_move[data.get_ply()] == 0)
+                ss->excluded_move == 0)
             {
                 int s_beta = tt_entry.score - se_mul * depth / 80;
-                data.singular_move[data.get_ply()] = chessmove.get_value();
+                ss->excluded_move = chessmove.get_value();
                 int s_score = alpha_beta<color, NodeType::Non_PV>(chessboard, data, s_beta - 1, s_beta, (depth - 1) / 2, cutnode);
-                data.singular_move[data.get_ply()] = 0;
+                ss->excluded_move = 0;
                 if (s_score < s_beta) {
                     ext = 1;
                     if constexpr(!is_pv) {
                         if (s_score + double_margin < s_beta) {
-                            ext = 2 + (chessboard.is_quiet(chessmove) && s_score + 62 < s_beta);
+                            ext = 2 + (is_quiet && s_score + 62 < s_beta);
                         }
                     }
                 } else if (s_beta >= beta) {
@@ -278,11 +328,13 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
 
         auto from = chessmove.get_from();
         auto to = chessmove.get_to();
-        auto piece = chessboard.get_piece(from);
-        data.prev_moves[data.get_ply()] = { piece, from, to };
+        ss->move = { chessmove.get_piece(), from, to };
+        ss->continuation = history->continuation(ss->move);
+        tt.prefetch(chessboard.key_after<color>(chessmove));
+        prefetch_move<color>(chessboard, chessmove);
         make_move<color, true>(chessboard, chessmove);
-        tt.prefetch(chessboard.get_hash_key());
         data.augment_ply();
+        history->prefetch_correction(chessboard, data);
 
         int new_depth = depth - 1 + ext;
 
@@ -290,10 +342,13 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
         if (moves_searched == 0) {
             score = -alpha_beta<enemy_color, NodeType::PV>(chessboard, data, -beta, -alpha, new_depth, false);
         } else {
-            // late move reduction
-            if (depth >= lmr_depth && movelist.get_move_score(moves_searched) < 1'000'000) {
-                if (is_quiet) {
-                    reduction -= movelist.get_move_score(moves_searched) / lmr_quiet_history;
+            // late move reduction, root moves ordered by the search before have no history in their score and are
+            // reduced by their place in the list alone
+            const int move_score = movelist.get_move_score(moves_searched);
+            const bool seeded = is_root && is_seeded_root_score(move_score);
+            if (depth >= lmr_depth && (seeded || move_score < 1'000'000)) {
+                if (is_quiet && !seeded) {
+                    reduction -= move_score / lmr_quiet_history;
                 }
                 reduction += !improving;
                 reduction -= tt_pv;
@@ -306,8 +361,10 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
             }
 
             score = -alpha_beta<enemy_color, NodeType::Non_PV>(chessboard, data, -alpha - 1, -alpha, new_depth - reduction, true);
+            SEARCH_STAT(data.stats.reduced_searches += reduction > 0);
 
             if (score > alpha && reduction > 0) {
+                SEARCH_STAT(data.stats.re_searches++);
                 if constexpr (!is_root) {
                     new_depth += (score > best_score + 80);
                     new_depth -= (score < best_score + new_depth);
@@ -326,6 +383,9 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
 
         if constexpr (is_root) {
             data.update_node_count(from, to, start_nodes);
+            if (!data.time_stopped()) {
+                data.update_root_score(from, to, score);
+            }
         }
 
         if (score > best_score) {
@@ -342,23 +402,25 @@ std::int16_t alpha_beta(board& chessboard, search_data& data, std::int16_t alpha
 
                 if (alpha >= beta) {
                     flag = Bound::LOWER;
+                    SEARCH_STAT(data.stats.fail_highs++);
+                    SEARCH_STAT(data.stats.first_move_fail_highs += quiets.size() + captures.size() == 0);
                     if (is_quiet) {
                         data.update_killer(chessmove);
                     }
-                    history->update<color, is_root>(data, chessboard, best_move, quiets, captures, depth + (best_score > beta + 80));
+                    history->update<color, is_root>(data, chessboard, chessmove, movelist, quiets, captures, depth + (best_score > beta + 80));
                     break;
                 }
             }
         }
 
         if (is_quiet) {
-            quiets.push_back(chessmove);
+            quiets.insert(moves_searched);
         } else {
-            captures.push_back(chessmove);
+            captures.insert(moves_searched);
         }
     }
 
-    if (data.singular_move[data.get_ply()] == 0) {
+    if (ss->excluded_move == 0) {
         int avg_eval = (raw_eval + static_eval * 2) / 3;
         if (!(in_check || !(best_move.get_value() == 0 || chessboard.is_quiet(best_move))
               || (flag == Bound::LOWER && best_score <= avg_eval) || (flag == Bound::UPPER && best_score >= avg_eval))
@@ -437,22 +499,122 @@ void iterative_deepening(board& chessboard, search_data& data, int max_depth) {
         }
 
         std::cout << "info depth " << depth << score_string << " nodes " << data.nodes() << " nps " << data.nps() << " pv " << data.get_pv(depth) << std::endl;
+        SEARCH_STAT(data.stats.iteration_nodes.push_back(data.get_nodes()));
         data.reset_nodes();
+        data.update_completed_line();
 
         best_move = data.best_move;
     }
+    SEARCH_STAT(data.stats.print());
+    SEARCH_STAT(last_search_stats = data.stats);
     std::cout << "bestmove " << best_move << "\n";
 }
 
+// plays the move that keeps the result of the root, with the fastest win or the slowest loss, without searching
+template <Color color>
+bool tablebase_root_move(board& chessboard) {
+    int root_plies;
+    const WDL root = tablebases.probe_dtm(chessboard, root_plies);
+    if (root == WDL::FAILED) {
+        return false;
+    }
+
+    stack_move_list moves;
+    generate_all_moves<color>(chessboard, moves);
+
+    chess_move best_move;
+    int best_plies = -1;
+    for (const chess_move& move : moves) {
+        make_move<color, false>(chessboard, move);
+        int plies = 0;
+        const WDL result = popcount(chessboard.get_occupancy()) == 2 ? WDL::DRAW : tablebases.probe_dtm(chessboard, plies);
+        undo_move<color, false>(chessboard, move);
+
+        if (result == WDL::FAILED) {
+            return false;
+        }
+
+        const bool keeps_result = (root == WDL::WIN && result == WDL::LOSS) || (root == WDL::DRAW && result == WDL::DRAW)
+                                  || (root == WDL::LOSS && result == WDL::WIN);
+        if (keeps_result && (best_plies < 0 || (root == WDL::WIN ? plies < best_plies : plies > best_plies))) {
+            best_move = move;
+            best_plies = plies;
+        }
+    }
+
+    if (best_plies < 0) {
+        return false;
+    }
+
+    std::string score_string = " score cp 0";
+    if (root != WDL::DRAW) {
+        score_string = " score mate " + std::to_string(root == WDL::WIN ? (root_plies + 1) / 2 : -root_plies / 2);
+    }
+
+    std::cout << "info depth 1" << score_string << " nodes 0 pv " << best_move.to_string() << std::endl;
+    std::cout << "bestmove " << best_move.to_string() << "\n";
+    return true;
+}
+
+// keeps the root moves for searching the same position again or the one after the best move and the expected reply
+template <Color color>
+void save_root_moves(board& chessboard, const search_data& data) {
+    constexpr Color enemy_color = color == White ? Black : White;
+    const chess_move best_move = data.get_completed_move(0);
+    const chess_move reply = data.get_completed_move(1);
+    std::uint64_t next_key = 0;
+
+    if (best_move.get_value() && reply.get_value()) {
+        make_move<color, false>(chessboard, best_move);
+        make_move<enemy_color, false>(chessboard, reply);
+        next_key = chessboard.get_hash_key();
+        undo_move<enemy_color, false>(chessboard, reply);
+        undo_move<color, false>(chessboard, best_move);
+    }
+
+    root_moves.save(chessboard.get_hash_key(), data.root_result(), next_key, data.get_completed_move(2));
+}
+
 void find_best_move(board& chessboard, time_info& info) {
-    search_data data;
+    chess_move book_reply;
+    if (book.probe(chessboard, book_reply)) {
+        std::cout << "bestmove " << book_reply.to_string() << "\n";
+        return;
+    }
+
+    if (chessboard.get_side() == White ? tablebase_root_move<White>(chessboard) : tablebase_root_move<Black>(chessboard)) {
+        return;
+    }
+
+    search_data data(history->sentinel(), history->continuation({}));
+    const bool white = chessboard.get_side() == White;
+    const bool timed = (white ? info.wtime : info.btime) != -1 || info.movetime != -1;
+    int max_depth = info.max_depth;
+
+    stack_move_list moves;
+    white ? generate_all_moves<White>(chessboard, moves) : generate_all_moves<Black>(chessboard, moves);
+    if (timed && moves.size() == 1) {
+        max_depth = std::min(max_depth, forced_move_depth);
+    }
+
+    if (white) {
+        data.set_timekeeper(info.wtime, info.winc, info.movestogo, chessboard.move_count(), info.max_nodes, info.movetime);
+    } else {
+        data.set_timekeeper(info.btime, info.binc, info.movestogo, chessboard.move_count(), info.max_nodes, info.movetime);
+    }
+
+    root_seed seed;
+    if (root_moves.seed(chessboard.get_hash_key(), seed)) {
+        data.seed_root(seed);
+    }
+    data.set_tablebase_root(tablebases.probe_wdl(chessboard) != WDL::FAILED);
 
-    if (chessboard.get_side() == White) {
-        data.set_timekeeper(info.wtime, info.winc, info.movestogo, chessboard.move_count(), info.max_nodes);
-        iterative_deepening<White>(chessboard, data, info.max_depth);
+    if (white) {
+        iterative_deepening<White>(chessboard, data, max_depth);
+        save_root_moves<White>(chessboard, data);
     } else {
-        data.set_timekeeper(info.btime, info.binc, info.movestogo, chessboard.move_count(), info.max_nodes);
-        iterative_deepening<Black>(chessboard, data, info.max_depth);
+        iterative_deepening<Black>(chessboard, data, max_depth);
+        save_root_moves<Black>(chessboard, data);
     }
 }
 
@@ -1,10 +1,14 @@
 #ifndef MOTOR_SEARCH_DATA_HPP
 #define MOTOR_SEARCH_DATA_HPP
 
+#include <array>
 #include <cstdint>
 
 #include "pv_table.hpp"
+#include "../move_generation/move_list.hpp"
 #include "time_keeper.hpp"
+#include "root_moves.hpp"
+#include "search_stats.hpp"
 #include "tables/transposition_table.hpp"
 
 constexpr std::int16_t INF = 20'000;
@@ -21,16 +25,38 @@ struct history_move {
     Square to = Square::A1;
 };
 
+// continuation history following one move, indexed by [side to move][piece][to]
+using continuation_history = std::array<std::array<std::array<std::int16_t, 64>, 7>, 2>;
+
+// search state of one ply, the entries below ply 0 are sentinels
+struct search_stack {
+    std::int16_t static_eval = INF;
+    history_move move = {};
+    std::uint32_t excluded_move = 0;
+    chess_move killer = {};
+    continuation_history * continuation = nullptr;
+};
+
+// sentinel entries below ply 0, enough for the deepest look back of the continuation history
+constexpr int stack_offset = 4;
+
 class search_data {
 public:
-    search_data() : ply(0), principal_variation_table(), timekeeper(), nodes_searched(0)  {}
+    // the sentinels get a continuation history that is never written, the other entries start at the one after a
+    // null move, like a ply that no move was played at yet
+    search_data(continuation_history * sentinel_continuation, continuation_history * null_continuation)
+            : ply(0), principal_variation_table(), timekeeper(), nodes_searched(0) {
+        for (int i = 0; i < int(search_stack_entries.size()); i++) {
+            search_stack_entries[i].continuation = i < stack_offset ? sentinel_continuation : null_continuation;
+        }
+    }
 
-    void set_timekeeper(int time, int bonus, int movestogo, int move_count, int max_nodes) {
-        timekeeper.reset(time, bonus, movestogo, move_count, max_nodes);
+    void set_timekeeper(int time, int bonus, int movestogo, int move_count, int max_nodes, int movetime = -1) {
+        timekeeper.reset(time, bonus, movestogo, move_count, max_nodes, movetime);
     }
 
-    bool should_end() {
-        return timekeeper.should_end(nodes_searched);
+    [[nodiscard]] bool should_end() const {
+        return timekeeper.should_end();
     }
 
     bool time_stopped() {
@@ -71,15 +97,23 @@ public:
     }
 
     void update_killer(chess_move move) {
-        killer_moves[ply] = move;
+        stack()->killer = move;
     }
 
     void reset_killers() {
-        killer_moves[ply + 2] = {};
+        stack()[2].killer = {};
+    }
+
+    [[nodiscard]] chess_move get_killer() const {
+        return stack()->killer;
     }
 
-    chess_move get_killer() {
-        return killer_moves[ply];
+    search_stack * stack() {
+        return &search_stack_entries[ply + stack_offset];
+    }
+
+    [[nodiscard]] const search_stack * stack() const {
+        return &search_stack_entries[ply + stack_offset];
     }
 
 
@@ -107,17 +141,61 @@ public:
         timekeeper.update_node_count(from, to, nodes_searched - node_count);
     }
 
-    std::uint64_t nps() {
-        return timekeeper.NPS(nodes_searched);
+    void update_root_score(int from, int to, int score) {
+        root_scores[from][to] = score;
+    }
+
+    // the root moves as the previous search left them
+    void seed_root(const root_seed & seed) {
+        seeded_root = seed;
+        timekeeper.seed(seed);
+    }
+
+    [[nodiscard]] const root_seed & get_root_seed() const {
+        return seeded_root;
     }
 
-    int improving[96] = {};
+    // with the root already in the tables, the tables only say which moves keep the result, not how to make progress
+    void set_tablebase_root(bool in_tables) {
+        tablebase_root = in_tables;
+    }
+
+    [[nodiscard]] bool is_tablebase_root() const {
+        return tablebase_root;
+    }
+
+    // the root moves as this search leaves them
+    [[nodiscard]] root_seed root_result() const {
+        root_seed result;
+        result.best_move = completed_line[0];
+        result.scores = root_scores;
+        // the node counts go on from the seed, so the total has to as well or the best move fraction drops below zero
+        result.node_count = timekeeper.get_node_count();
+        result.nodes = timekeeper.get_seeded_nodes() + timekeeper.get_total_nodes() + nodes_searched;
+        return result;
+    }
+
+    // keeps the start of the principal variation of the last finished iteration
+    void update_completed_line() {
+        for (int i = 0; i < int(completed_line.size()); i++) {
+            completed_line[i] = i < principal_variation_table.get_length() ? principal_variation_table.get_move(i) : chess_move{};
+        }
+    }
 
-    history_move prev_moves[96];
+    [[nodiscard]] chess_move get_completed_move(int index) const {
+        return completed_line[index];
+    }
+
+    std::uint64_t nps() {
+        return timekeeper.NPS(nodes_searched);
+    }
 
-    std::uint32_t singular_move[96] = {};
     int stack_eval = {};
     std::string best_move = {};
+
+    SEARCH_STAT(search_stats stats;)
+
+    move_arena arena;
 private:
     std::int16_t ply;
 
@@ -126,7 +204,12 @@ private:
     time_keeper timekeeper;
 
     std::uint64_t nodes_searched;
-    chess_move killer_moves[96] = {};
+    std::array<search_stack, stack_offset + 96> search_stack_entries;
+
+    root_seed seeded_root;
+    root_table<int> root_scores = root_seed().scores;
+    std::array<chess_move, 3> completed_line = {};
+    bool tablebase_root = false;
 };
 
 #endif //MOTOR_SEARCH_DATA_HPP
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef MOTOR_SEARCH_STATS_HPP
+#define MOTOR_SEARCH_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The counters are only compiled in with MOTOR_STATS defined (cmake -DMOTOR_STATS=ON or make STATS=1), without it the
+// statements in SEARCH_STAT vanish and the search is the same as without them.
+#ifdef MOTOR_STATS
+#define SEARCH_STAT(statement) statement
+#else
+#define SEARCH_STAT(statement)
+#endif
+
+enum class Prune : std::uint8_t {
+    Razoring, Reverse_Futility, Null_Move, Probcut, Late_Move, Futility, See, Count
+};
+
+// by node type of alpha_beta and a last entry for quiescence search
+constexpr int STAT_NODE_TYPES = 5;
+
+// what the search did, each thread counts into its own search_data
+struct search_stats {
+    std::array<std::uint64_t, STAT_NODE_TYPES> tt_probes = {};
+    std::array<std::uint64_t, STAT_NODE_TYPES> tt_hits = {};
+    std::array<std::uint64_t, STAT_NODE_TYPES> tt_cutoffs = {};
+    std::array<std::uint64_t, static_cast<int>(Prune::Count)> prunes = {};
+    std::uint64_t fail_highs = 0;
+    std::uint64_t first_move_fail_highs = 0;
+    std::uint64_t reduced_searches = 0;
+    std::uint64_t re_searches = 0;
+    std::uint64_t main_nodes = 0;
+    std::uint64_t qsearch_nodes = 0;
+    std::vector<std::uint64_t> iteration_nodes;
+
+    void tt_probe(int node_type, bool hit) {
+        tt_probes[node_type]++;
+        tt_hits[node_type] += hit;
+    }
+
+    void prune(Prune kind) {
+        prunes[static_cast<int>(kind)]++;
+    }
+
+    search_stats & operator+=(const search_stats & other) {
+        for (int i = 0; i < STAT_NODE_TYPES; i++) {
+            tt_probes[i] += other.tt_probes[i];
+            tt_hits[i] += other.tt_hits[i];
+            tt_cutoffs[i] += other.tt_cutoffs[i];
+        }
+        for (std::size_t i = 0; i < prunes.size(); i++) {
+            prunes[i] += other.prunes[i];
+        }
+        fail_highs += other.fail_highs;
+        first_move_fail_highs += other.first_move_fail_highs;
+        reduced_searches += other.reduced_searches;
+        re_searches += other.re_searches;
+        main_nodes += other.main_nodes;
+        qsearch_nodes += other.qsearch_nodes;
+
+        iteration_nodes.resize(std::max(iteration_nodes.size(), other.iteration_nodes.size()));
+        for (std::size_t i = 0; i < other.iteration_nodes.size(); i++) {
+            iteration_nodes[i] += other.iteration_nodes[i];
+        }
+        return *this;
+    }
+
+    // one info string line per group of counters, rates in percent
+    void print() const {
+        constexpr std::array<const char *, STAT_NODE_TYPES> node_names = {"root", "pv", "nonpv", "null", "qs"};
+        constexpr std::array<const char *, static_cast<int>(Prune::Count)> prune_names = {
+            "razoring", "rfp", "nmp", "probcut", "lmp", "fp", "see"
+        };
+
+        auto percent = [](std::uint64_t part, std::uint64_t whole) {
+            std::stringstream value;
+            value << std::fixed << std::setprecision(1) << (whole ? 100.0 * double(part) / double(whole) : 0.0);
+            return value.str();
+        };
+
+        std::cout << "info string stats tt";
+        for (int i = 0; i < STAT_NODE_TYPES; i++) {
+            std::cout << " " << node_names[i] << " " << tt_probes[i] << " probes " << percent(tt_hits[i], tt_probes[i])
+                      << "% hits " << percent(tt_cutoffs[i], tt_probes[i]) << "% cutoffs";
+        }
+        std::cout << std::endl;
+
+        std::cout << "info string stats prunes";
+        for (std::size_t i = 0; i < prunes.size(); i++) {
+            std::cout << " " << prune_names[i] << " " << prunes[i];
+        }
+        std::cout << std::endl;
+
+        std::cout << "info string stats failhigh " << fail_highs << " first " << percent(first_move_fail_highs, fail_highs)
+                  << "% lmr " << reduced_searches << " research " << percent(re_searches, reduced_searches)
+                  << "% qsnodes " << percent(qsearch_nodes, main_nodes + qsearch_nodes) << "%" << std::endl;
+
+        // nodes of an iteration over the nodes of the one before
+        std::cout << "info string stats ebf";
+        for (std::size_t i = 1; i < iteration_nodes.size(); i++) {
+            std::cout << std::fixed << std::setprecision(2) << " "
+                      << (iteration_nodes[i - 1] ? double(iteration_nodes[i]) / double(iteration_nodes[i - 1]) : 0.0);
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+};
+
+// the counters of the last search for the stats command
+SEARCH_STAT(search_stats last_search_stats;)
+
+#endif //MOTOR_SEARCH_STATS_HPP
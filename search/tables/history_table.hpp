@@ -40,64 +40,52 @@ public:
     }
 
     template <Color color, bool is_root>
-    void update(search_data &data, board &chessboard, const chess_move &best_move, move_list &quiets, move_list &captures, int depth) {
+    void update(search_data &data, board &chessboard, const extended_move &best_move, const move_list &movelist,
+                const move_subset &quiets, const move_subset &captures, int depth) {
         int bonus = history_bonus(depth);
         int penalty = -bonus;
 
-        auto [piece, from, to] = data.prev_moves[data.get_ply()];
-        history_move prev = {}, prev2 = {}, prev4 = {};
+        const search_stack * ss = data.stack();
+        auto [piece, from, to] = ss->move;
 
         const std::uint64_t threats = chessboard.get_threats();
         const std::uint64_t pawn_key = chessboard.get_pawn_key() % 512;
 
-        if (chessboard.is_quiet(best_move)) {
+        if (best_move.is_quiet()) {
             bool threat_from = (threats & bb(from));
             bool threat_to = (threats & bb(to));
             update_history(history_table[color][threat_from][threat_to][from][to], bonus);
             update_history(pawn_history_table[color][pawn_key][piece][to], bonus);
 
             if constexpr (!is_root) {
-                prev = data.prev_moves[data.get_ply() - 1];
-                update_history(continuation_table[color][prev.piece_type][prev.to][piece][to], bonus);
-                if (data.get_ply() > 1) {
-                    prev2 = data.prev_moves[data.get_ply() - 2];
-                    update_history(continuation_table[color][prev2.piece_type][prev2.to][piece][to], bonus);
-                    if (data.get_ply() > 3) {
-                        prev4 = data.prev_moves[data.get_ply() - 4];
-                        update_history(continuation_table[color][prev4.piece_type][prev4.to][piece][to], bonus);
-                    }
-                }
+                update_continuation_history<color>(ss, piece, to, bonus);
             }
 
-            for (const auto &quiet : quiets) {
+            quiets.for_each([&](int index) {
+                const auto &quiet = movelist.get_move(index);
                 auto qfrom = quiet.get_from();
                 auto qto = quiet.get_to();
-                auto qpiece = chessboard.get_piece(qfrom);
+                auto qpiece = quiet.get_piece();
                 bool qthreat_from = (threats & bb(qfrom));
                 bool qthreat_to = (threats & bb(qto));
                 update_history(history_table[color][qthreat_from][qthreat_to][qfrom][qto], penalty);
                 update_history(pawn_history_table[color][pawn_key][qpiece][qto], penalty);
 
                 if constexpr (!is_root) {
-                    update_history(continuation_table[color][prev.piece_type][prev.to][qpiece][qto], penalty);
-                    if (data.get_ply() > 1) {
-                        update_history(continuation_table[color][prev2.piece_type][prev2.to][qpiece][qto], penalty);
-                        if (data.get_ply() > 3) {
-                            update_history(continuation_table[color][prev4.piece_type][prev4.to][qpiece][qto], penalty);
-                        }
-                    }
+                    update_continuation_history<color>(ss, qpiece, qto, penalty);
                 }
-            }
+            });
         } else {
             const auto threat_to = static_cast<bool>(threats & bb(to));
-            update_cap_history(capture_table[color][threat_to][piece][to][chessboard.get_piece(to)], bonus);
+            update_cap_history(capture_table[color][threat_to][piece][to][best_move.get_captured()], bonus);
         }
 
-        for (const auto &capture : captures) {
+        captures.for_each([&](int index) {
+            const auto &capture = movelist.get_move(index);
             const auto cap_to = capture.get_to();
             const auto threat_to = static_cast<bool>(threats & bb(cap_to));
-            update_cap_history(capture_table[color][threat_to][chessboard.get_piece(capture.get_from())][cap_to][chessboard.get_piece(cap_to)], penalty);
-        }
+            update_cap_history(capture_table[color][threat_to][capture.get_piece()][cap_to][capture.get_captured()], penalty);
+        });
     }
 
     template <Color color>
@@ -110,23 +98,24 @@ public:
         int move_score = history_table[color][threat_from][threat_to][from][to];
         move_score += pawn_history_table[color][pawn_key][piece][to];
 
-        int ply = data.get_ply();
-        if (ply > 0) {
-            auto prev = data.prev_moves[ply - 1];
-            move_score += continuation_table[color][prev.piece_type][prev.to][piece][to];
-            if (ply > 1) {
-                auto prev2 = data.prev_moves[ply - 2];
-                move_score += continuation_table[color][prev2.piece_type][prev2.to][piece][to];
-                if (ply > 3) {
-                    auto prev4 = data.prev_moves[ply - 4];
-                    move_score += continuation_table[color][prev4.piece_type][prev4.to][piece][to];
-                }
-            }
-        }
+        const search_stack * ss = data.stack();
+        move_score += (*ss[-1].continuation)[color][piece][to];
+        move_score += (*ss[-2].continuation)[color][piece][to];
+        move_score += (*ss[-4].continuation)[color][piece][to];
 
         return move_score;
     }
 
+    // continuation history following the move, stored in the search stack
+    continuation_history * continuation(const history_move & move) {
+        return &continuation_table[move.piece_type][move.to];
+    }
+
+    // continuation history of the stack entries below ply 0, always zero as nothing is written through it
+    continuation_history * sentinel() {
+        return &sentinel_continuation;
+    }
+
     template <Color color>
     int get_capture_score(board & chessboard, Piece from_piece, Square to, Piece to_piece) const {
         const auto threat_to = static_cast<bool>(chessboard.get_threats() & bb(to));
@@ -143,9 +132,9 @@ public:
         constexpr int CORRECTION_CLAMP_MAX = 12'288;
         constexpr int CORRECTION_TABLE_SIZE = 16384;
 
-        auto update_entry = [&](int& entry) {
-            entry = (entry * (256 - weight) + diff * weight) / 256;
-            entry = std::clamp(entry, CORRECTION_CLAMP_MIN, CORRECTION_CLAMP_MAX);
+        auto update_entry = [&](std::int16_t& entry) {
+            const int updated = (entry * (256 - weight) + diff * weight) / 256;
+            entry = static_cast<std::int16_t>(std::clamp(updated, CORRECTION_CLAMP_MIN, CORRECTION_CLAMP_MAX));
         };
 
         update_entry(pawn_correction_table[color][chessboard.get_pawn_key() % CORRECTION_TABLE_SIZE]);
@@ -160,18 +149,39 @@ public:
         update_entry(minor_correction_table[color][chessboard.get_minor_key() % CORRECTION_TABLE_SIZE]);
         update_entry(major_correction_table[color][chessboard.get_major_key() % CORRECTION_TABLE_SIZE]);
 
+        // the moves of the sentinels below ply 0 would share the entries of the null move
+        const search_stack * ss = data.stack();
+        const auto & prev1 = ss[-1].move;
+        const auto & prev2 = ss[-2].move;
+        const auto & prev3 = ss[-3].move;
         if (data.get_ply() > 1) {
-            auto prev1 = data.prev_moves[data.get_ply() - 1];
-            auto prev2 = data.prev_moves[data.get_ply() - 2];
             update_entry(continuation_correction_table[prev2.piece_type][prev2.to][prev1.piece_type][prev1.to]);
-
-            if (data.get_ply() > 2) {
-                auto prev3 = data.prev_moves[data.get_ply() - 3];
-                update_entry(continuation_correction_table2[prev3.piece_type][prev3.to][prev1.piece_type][prev1.to]);
-            }
+        }
+        if (data.get_ply() > 2) {
+            update_entry(continuation_correction_table2[prev3.piece_type][prev3.to][prev1.piece_type][prev1.to]);
         }
     }
 
+    // prefetches the correction entries correct_eval reads at the node after a move, for the side to move there, the
+    // threat key is left out because it needs the threats of the new position
+    void prefetch_correction(const board &chessboard, const search_data &data) const {
+        const Color color = chessboard.get_side();
+        __builtin_prefetch(&pawn_correction_table[color][chessboard.get_pawn_key() % 16384]);
+        __builtin_prefetch(&minor_correction_table[color][chessboard.get_minor_key() % 16384]);
+        __builtin_prefetch(&major_correction_table[color][chessboard.get_major_key() % 16384]);
+
+        auto [wkey, bkey] = chessboard.get_nonpawn_key();
+        __builtin_prefetch(&nonpawn_correction_table[color][White][wkey % 16384]);
+        __builtin_prefetch(&nonpawn_correction_table[color][Black][bkey % 16384]);
+
+        const search_stack * ss = data.stack();
+        const auto & prev1 = ss[-1].move;
+        const auto & prev2 = ss[-2].move;
+        const auto & prev3 = ss[-3].move;
+        __builtin_prefetch(&continuation_correction_table[prev2.piece_type][prev2.to][prev1.piece_type][prev1.to]);
+        __builtin_prefetch(&continuation_correction_table2[prev3.piece_type][prev3.to][prev1.piece_type][prev1.to]);
+    }
+
     template <Color color>
     std::int16_t correct_eval(const board &chessboard, const search_data &data, int raw_eval) {
         if (std::abs(raw_eval) > 8'000) return raw_eval;
@@ -185,46 +195,52 @@ public:
         auto [wkey, bkey] = chessboard.get_nonpawn_key();
         const int nonpawn_entry = nonpawn_correction_table[color][White][wkey % 16384] + nonpawn_correction_table[color][Black][bkey % 16384];
 
-        int cont_entry = 0;
-        int cont_entry2 = 0;
-        if (data.get_ply() > 1) {
-            auto prev1 = data.prev_moves[data.get_ply() - 1];
-            auto prev2 = data.prev_moves[data.get_ply() - 2];
-            cont_entry = continuation_correction_table[prev2.piece_type][prev2.to][prev1.piece_type][prev1.to];
-            if (data.get_ply() > 2) {
-                auto prev3 = data.prev_moves[data.get_ply() - 3];
-                cont_entry2 = continuation_correction_table2[prev3.piece_type][prev3.to][prev1.piece_type][prev1.to];
-            }
-        }
+        const search_stack * ss = data.stack();
+        const auto & prev1 = ss[-1].move;
+        const auto & prev2 = ss[-2].move;
+        const auto & prev3 = ss[-3].move;
+        const int cont_entry = data.get_ply() > 1 ? continuation_correction_table[prev2.piece_type][prev2.to][prev1.piece_type][prev1.to] : 0;
+        const int cont_entry2 = data.get_ply() > 2 ? continuation_correction_table2[prev3.piece_type][prev3.to][prev1.piece_type][prev1.to] : 0;
 
         return raw_eval + (pawn_entry * 200 + threat_entry * 100 + nonpawn_entry * 200 + minor_entry * 150 + major_entry * 120 + cont_entry * 180 + cont_entry2 * 180) / (256 * 300);
     }
 
 
 private:
-    std::array<std::array<std::array<std::array<std::array<int, 64>, 64>, 2>, 2>, 2> history_table;
-    std::array<std::array<std::array<std::array<int, 64>, 7>, 512>, 2> pawn_history_table;
-    std::array<std::array<std::array<std::array<std::array<int, 64>, 7>, 64>, 7>, 2> continuation_table;
-    std::array<std::array<std::array<std::array<std::array<int, 7>, 64>, 6>, 2>, 2> capture_table;
-    std::array<std::array<int, 16384>, 2> pawn_correction_table;
-    std::array<std::array<std::array<int, 16384>, 2>, 2> nonpawn_correction_table;
-    std::array<std::array<int, 16384>, 2> minor_correction_table;
-    std::array<std::array<int, 16384>, 2> major_correction_table;
-    std::array<std::array<int, 16384>, 2> threat_correction_table;
-    std::array<std::array<std::array<std::array<int, 64>, 7>, 64>, 7> continuation_correction_table;
-    std::array<std::array<std::array<std::array<int, 64>, 7>, 64>, 7> continuation_correction_table2;
+    // entries are int16, gravity keeps history within +-16384 and corrections are clamped to +-12288
+    std::array<std::array<std::array<std::array<std::array<std::int16_t, 64>, 64>, 2>, 2>, 2> history_table;
+    std::array<std::array<std::array<std::array<std::int16_t, 64>, 7>, 512>, 2> pawn_history_table;
+    std::array<std::array<continuation_history, 64>, 7> continuation_table;
+    continuation_history sentinel_continuation = {};
+    std::array<std::array<std::array<std::array<std::array<std::int16_t, 7>, 64>, 6>, 2>, 2> capture_table;
+    std::array<std::array<std::int16_t, 16384>, 2> pawn_correction_table;
+    std::array<std::array<std::array<std::int16_t, 16384>, 2>, 2> nonpawn_correction_table;
+    std::array<std::array<std::int16_t, 16384>, 2> minor_correction_table;
+    std::array<std::array<std::int16_t, 16384>, 2> major_correction_table;
+    std::array<std::array<std::int16_t, 16384>, 2> threat_correction_table;
+    std::array<std::array<std::array<std::array<std::int16_t, 64>, 7>, 64>, 7> continuation_correction_table;
+    std::array<std::array<std::array<std::array<std::int16_t, 64>, 7>, 64>, 7> continuation_correction_table2;
 
     int history_bonus(int depth) const {
         return std::min(2040, 236 * depth);
     }
 
-    void update_history(int &value, int bonus) const {
-        value += bonus - (value * std::abs(bonus) / 16384);
+    template <Color color>
+    void update_continuation_history(const search_stack * ss, Piece piece, Square to, int bonus) {
+        for (const int back : {1, 2, 4}) {
+            if (ss[-back].continuation != &sentinel_continuation) {
+                update_history((*ss[-back].continuation)[color][piece][to], bonus);
+            }
+        }
+    }
+
+    void update_history(std::int16_t &value, int bonus) const {
+        value = static_cast<std::int16_t>(value + bonus - (value * std::abs(bonus) / 16384));
     }
 
-    void update_cap_history(int &value, int bonus) const {
+    void update_cap_history(std::int16_t &value, int bonus) const {
         constexpr int noisy_gravity = 16384;
-        value += bonus - (value * std::abs(bonus) / noisy_gravity);
+        value = static_cast<std::int16_t>(value + bonus - (value * std::abs(bonus) / noisy_gravity));
     }
 };
 
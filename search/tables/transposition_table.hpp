@@ -4,6 +4,9 @@
 #include <vector>
 #include <cstdint>
 
+#include "../../profiler.hpp"
+#include "../../tablebase/tablebase.hpp"
+
 enum class Bound : std::uint8_t {
     INVALID,// Type 0 - invalid TT entryy
     EXACT,  // Type 1 - score is exact
@@ -11,6 +14,9 @@ enum class Bound : std::uint8_t {
     UPPER   // Type 3 - score is lower than alpha (fail-low)  - Alpha node
 };
 
+// mate and tablebase scores count the plies from the root, the table keeps them as plies from the node
+constexpr std::int16_t TT_PLY_SCORE = TB_WIN - 100;
+
 struct TT_entry {
     Bound bound = Bound::INVALID; // 8 bits
     std::int8_t depth = 0;        // 8 bits
@@ -38,6 +44,10 @@ public:
         tt_table.resize(this->cluster_count);
     }
 
+    [[nodiscard]] std::uint64_t byte_size() const {
+        return cluster_count * sizeof(TT_CLUSTER);
+    }
+
     void clear() {
         tt_table = std::vector<TT_CLUSTER>(cluster_count);
         age = 1; // reset TT age
@@ -49,10 +59,11 @@ public:
 
     void store(const Bound flag, const std::int8_t depth, const std::int16_t best_score, const std::int16_t raw_eval,
                const chess_move best_move, const std::int16_t ply, const bool tt_pv, const std::uint64_t zobrist_key) {
+        PROFILE_SECTION(TT_Store);
 
         const int16_t stored_score = [&] {
-            if (best_score > 19'000) return static_cast<int16_t>(best_score + ply);
-            if (best_score < -19'000) return static_cast<int16_t>(best_score - ply);
+            if (best_score > TT_PLY_SCORE) return static_cast<int16_t>(best_score + ply);
+            if (best_score < -TT_PLY_SCORE) return static_cast<int16_t>(best_score - ply);
             return best_score;
         }();
 
@@ -87,13 +98,14 @@ public:
     }
 
     TT_entry retrieve(const std::uint64_t zobrist_key, const std::int16_t ply) {
+        PROFILE_SECTION(TT_Probe);
         TT_CLUSTER &cluster = tt_table[get_index(zobrist_key)];
 
         for (auto &entry : cluster.entries) {
             if (entry.zobrist == upper(zobrist_key)) {
                 entry.score = [&] {
-                    if (entry.score > 19'000) return static_cast<int16_t>(entry.score - ply);
-                    if (entry.score < -19'000) return static_cast<int16_t>(entry.score + ply);
+                    if (entry.score > TT_PLY_SCORE) return static_cast<int16_t>(entry.score - ply);
+                    if (entry.score < -TT_PLY_SCORE) return static_cast<int16_t>(entry.score + ply);
                     return entry.score;
                 }();
                 return entry;
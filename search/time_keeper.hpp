@@ -1,17 +1,25 @@
 #ifndef MOTOR_TIME_KEEPER_HPP
 #define MOTOR_TIME_KEEPER_HPP
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <climits>
+#include <mutex>
+#include <thread>
 #include "../chess_board/chess_move.hpp"
 #include "tuning_options.hpp"
+#include "root_moves.hpp"
 
 struct time_info {
-    int wtime = -1, btime = -1, winc = 0, binc = 0, movestogo = 0, max_depth = 64;
+    int wtime = -1, btime = -1, winc = 0, binc = 0, movestogo = 0, max_depth = 64, mate = 0, movetime = -1;
     std::uint64_t max_nodes = static_cast<std::uint64_t>(INT_MAX) / 2;
 };
 
+// Move Overhead, the milliseconds kept back from every deadline for the time the GUI and the connection take
+int move_overhead = 50;
+
 TuningOption tm_expect_mul("tm_expect_mul", 41, 20, 70);
 TuningOption tm_mul("tm_mul", 86, 40, 150);
 TuningOption tm_stability_const("tm_stability_const", 137, 50, 400);
@@ -24,20 +32,37 @@ public:
     time_keeper() : stop(false), inf_time(false), time_limit(0), optimal_time_limit(0),
                     max_nodes(static_cast<std::uint64_t>(INT_MAX) / 2), total_nodes(0), node_count{} {}
 
-    void reset(int time, int increment = 0, int movestogo = 0, int move_count = 1, std::uint64_t nodes = static_cast<std::uint64_t>(INT_MAX) / 2) {
+    ~time_keeper() {
+        cancel_timer();
+    }
+
+    // a movetime other than -1 searches for that long and ignores the clock
+    void reset(int time, int increment = 0, int movestogo = 0, int move_count = 1, std::uint64_t nodes = static_cast<std::uint64_t>(INT_MAX) / 2, int movetime = -1) {
+        cancel_timer();
         start_time = std::chrono::steady_clock::now();
         stop = false;
-        const int time_minus_threshold = time - 50;
+        const int time_minus_threshold = time - move_overhead;
         max_nodes = nodes;
         total_nodes = 0;
         inf_time = false;
         node_count = {};
+        seeded_nodes = 0;
         last_best_move = {};
         stability_count = 0;
 
+        fixed_time = movetime != -1;
+        if (fixed_time) {
+            time_limit = optimal_time_limit = std::max(1, movetime - move_overhead);
+            start_timer();
+            return;
+        }
+
         if (time == -1) {
             inf_time = true;
-        } else if (movestogo == 0) {
+            return;
+        }
+
+        if (movestogo == 0) {
             double time_divider = tm_expect_mul.value * std::pow(1.0 + 1.5 * std::pow(double(move_count) / tm_expect_mul.value, 2), 0.5) - move_count;
             optimal_time_limit = std::clamp((tm_mul.value / 100.0) * (time_minus_threshold / time_divider + increment), 10.0, std::max(50.0, time_minus_threshold / 2.0));
             time_limit = std::clamp(time_minus_threshold / std::log(time_divider) + increment, 10.0, std::max(50.0, time_minus_threshold / 2.0));
@@ -47,10 +72,11 @@ public:
         }
         optimal_time_limit = std::min(optimal_time_limit, time_minus_threshold);
         time_limit = std::min(time_limit, time_minus_threshold);
+        start_timer();
     }
 
     [[nodiscard]] bool stopped() const {
-        return stop;
+        return stop.load(std::memory_order_relaxed);
     }
 
     bool can_end(std::uint64_t nodes, const chess_move& best_move, int depth) {
@@ -62,7 +88,7 @@ public:
             return true;
         }
 
-        if (inf_time) {
+        if (inf_time || fixed_time) {
             return false;
         }
 
@@ -77,7 +103,7 @@ public:
             }
             stability_scale = tm_stability_const.value / 100.0 - tm_stability_mul.value / 1000.0 * std::min(10, stability_count);
 
-            double bm_frac = 1.0 - double(node_count[best_move.get_from()][best_move.get_to()]) / nodes;
+            double bm_frac = 1.0 - double(node_count[best_move.get_from()][best_move.get_to()]) / (nodes + seeded_nodes);
             opt_scale = bm_frac * tm_node_mul.value / 100.0 + tm_node_const.value / 100.0;
         }
 
@@ -87,19 +113,9 @@ public:
         return stop;
     }
 
-    bool should_end(std::uint64_t nodes = 0) { // called in alphabeta
-        if (stop || total_nodes >= max_nodes) {
-            return true;
-        }
-
-        if (inf_time) {
-            return false;
-        }
-
-        if((nodes & 1023) == 0) {
-            stop = elapsed() >= time_limit;
-        }
-        return stop;
+    // called in alphabeta, the timer thread sets stop at the hard limit
+    [[nodiscard]] bool should_end() const {
+        return stop.load(std::memory_order_relaxed) || total_nodes >= max_nodes;
     }
 
     int elapsed() {
@@ -118,6 +134,11 @@ public:
         return 0;
     }
 
+    // milliseconds after the start at which the timer stops the search
+    [[nodiscard]] int hard_limit() const {
+        return time_limit;
+    }
+
     [[nodiscard]] std::uint64_t get_total_nodes() const {
         return total_nodes;
     }
@@ -130,17 +151,63 @@ public:
         node_count[from][to] += delta;
     }
 
+    // starts from the node counts and best move of the search before, after reset
+    void seed(const root_seed & seed) {
+        node_count = seed.node_count;
+        seeded_nodes = seed.nodes;
+        last_best_move = seed.best_move;
+    }
+
+    [[nodiscard]] const root_table<int> & get_node_count() const {
+        return node_count;
+    }
+
+    [[nodiscard]] std::uint64_t get_seeded_nodes() const {
+        return seeded_nodes;
+    }
+
 private:
     std::chrono::time_point<std::chrono::steady_clock> start_time;
-    bool stop;
+    std::atomic<bool> stop;
     bool inf_time;
+    bool fixed_time = false;
     int time_limit;
     int optimal_time_limit;
     std::uint64_t max_nodes;
     std::uint64_t total_nodes;
-    std::array<std::array<int, 64>, 64> node_count;
+    root_table<int> node_count;
+    std::uint64_t seeded_nodes = 0;
     chess_move last_best_move;
     int stability_count;
+
+    std::thread timer;
+    std::mutex timer_mutex;
+    std::condition_variable timer_signal;
+    bool timer_cancelled = false;
+
+    // sleeps until the hard limit unless the search ends first
+    void start_timer() {
+        const auto deadline = start_time + std::chrono::milliseconds(time_limit);
+        timer_cancelled = false;
+        timer = std::thread([this, deadline] {
+            std::unique_lock lock(timer_mutex);
+            if (!timer_signal.wait_until(lock, deadline, [this] { return timer_cancelled; })) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    void cancel_timer() {
+        if (!timer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard lock(timer_mutex);
+            timer_cancelled = true;
+        }
+        timer_signal.notify_one();
+        timer.join();
+    }
 };
 
 #endif //MOTOR_TIME_KEEPER_HPP
\ No newline at end of file
@@ -0,0 +1,367 @@
+#ifndef MOTOR_TABLEBASE_GENERATOR_HPP
+#define MOTOR_TABLEBASE_GENERATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "tablebase.hpp"
+#include "../move_generation/move_list.hpp"
+#include "../move_generation/move_generator.hpp"
+#include "../executioner/makemove.hpp"
+
+// values during generation are the plies to mate plus one, signed by the result for the side to move
+constexpr std::int8_t TB_UNKNOWN = -128;
+
+constexpr std::int8_t tb_win(int plies) { return static_cast<std::int8_t>(plies + 1); }
+constexpr std::int8_t tb_loss(int plies) { return static_cast<std::int8_t>(-plies - 1); }
+constexpr int tb_plies(std::int8_t value) { return std::abs(value) - 1; }
+
+// The tables are built by retrograde analysis. The first pass values every position from its moves, which finds the
+// mates, the stalemates and the results that captures and promotions into smaller tables decide. After that a pass
+// only looks at the positions one move before those found in the pass before, generated by taking moves back, and
+// pass k keeps the positions that are won or lost in k plies. Positions that are decided but further away come back
+// in the pass of their plies. The positions left once nothing is found any more are draws.
+// All tables are kept in memory until the end, as the tables with pawns need the ones their promotions lead to.
+// The fifty move rule is ignored.
+class tablebase_generator {
+public:
+    explicit tablebase_generator(unsigned int threads) : threads(std::max(1u, threads)) {}
+
+    // every table reached by the captures and promotions of the layout must be generated first, returns the longest win
+    int generate(const tb_layout & layout) {
+        auto & table = *generated.emplace_back(std::make_unique<table_values>(table_values{layout, std::vector<std::int8_t>(layout.size(), TB_UNKNOWN)}));
+        lookup.emplace(layout.material_key(false), std::pair(&table, false));
+        lookup.emplace(layout.material_key(true), std::pair(&table, true));
+
+        pass_output found = parallel_for(table.values.size(), [&](board & chessboard, std::uint64_t index, pass_output & output) {
+            resolve(chessboard, table, index, 0, output);
+        });
+
+        // by the plies of their result, which go up to 126 in the signed bytes
+        std::vector<std::vector<std::uint64_t>> deferred(128);
+        for (int pass = 1; pass < static_cast<int>(deferred.size()); pass++) {
+            for (const auto & [plies, index] : found.deferred) {
+                deferred[plies].push_back(index);
+            }
+
+            pass_output predecessors = parallel_for(found.resolved.size(), [&](board &, std::uint64_t i, pass_output & output) {
+                add_predecessors(table, found.resolved[i], output);
+            });
+            std::vector<std::uint64_t> & candidates = predecessors.candidates;
+            candidates.insert(candidates.end(), deferred[pass].begin(), deferred[pass].end());
+            std::vector<std::uint64_t>().swap(deferred[pass]);
+
+            std::ranges::sort(candidates);
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            if (candidates.empty() && predecessors.resolved.empty()
+                && std::all_of(deferred.begin() + pass, deferred.end(), [](const auto & later) { return later.empty(); })) {
+                break;
+            }
+
+            found = parallel_for(candidates.size(), [&](board & chessboard, std::uint64_t i, pass_output & output) {
+                resolve(chessboard, table, candidates[i], pass, output);
+            });
+            found.resolved.insert(found.resolved.end(), predecessors.resolved.begin(), predecessors.resolved.end());
+        }
+
+        int table_plies = 0;
+        for (std::int8_t & value : table.values) {
+            if (value == TB_UNKNOWN) {
+                value = 0;
+            }
+            table_plies = std::max(table_plies, tb_plies(value));
+        }
+        return table_plies;
+    }
+
+    // two bits per position in the .wdl file and the signed plies to mate in the .dtm file
+    bool write(const std::string & directory, const tb_layout & layout, bool with_dtm) const {
+        const auto & [table, flipped] = lookup.at(layout.material_key(false));
+        const std::string path = directory + "/" + layout.name;
+
+        std::vector<std::uint8_t> wdl((table->values.size() + 3) / 4);
+        for (std::size_t index = 0; index < table->values.size(); index++) {
+            const std::int8_t value = table->values[index];
+            const WDL result = value > 0 ? WDL::WIN : value < 0 ? WDL::LOSS : WDL::DRAW;
+            wdl[index / 4] |= static_cast<std::uint8_t>(result) << (index % 4 * 2);
+        }
+
+        std::ofstream wdl_file(path + ".wdl", std::ios::binary);
+        wdl_file.write(reinterpret_cast<const char *>(wdl.data()), static_cast<std::streamsize>(wdl.size()));
+        if (!wdl_file) {
+            return false;
+        }
+
+        if (with_dtm) {
+            std::ofstream dtm_file(path + ".dtm", std::ios::binary);
+            dtm_file.write(reinterpret_cast<const char *>(table->values.data()), static_cast<std::streamsize>(table->values.size()));
+            return static_cast<bool>(dtm_file);
+        }
+        return true;
+    }
+
+private:
+    struct table_values {
+        tb_layout layout;
+        std::vector<std::int8_t> values;
+    };
+
+    // the positions a pass found, the ones it put off to the pass of their plies and the ones it has to search
+    struct pass_output {
+        std::vector<std::uint64_t> resolved;
+        std::vector<std::pair<int, std::uint64_t>> deferred;
+        std::vector<std::uint64_t> candidates;
+    };
+
+    unsigned int threads;
+    std::vector<std::unique_ptr<table_values>> generated;
+    std::unordered_map<std::uint64_t, std::pair<table_values *, bool>> lookup;
+
+    template <typename Work>
+    pass_output parallel_for(std::uint64_t size, Work work) {
+        constexpr std::uint64_t chunk = 4096;
+        std::atomic<std::uint64_t> next = 0;
+        pass_output merged;
+        std::mutex merge_mutex;
+
+        std::vector<std::thread> workers;
+        for (unsigned int thread = 0; thread < threads; thread++) {
+            workers.emplace_back([&] {
+                auto chessboard = std::make_unique<board>();
+                pass_output output;
+                for (std::uint64_t begin; (begin = next.fetch_add(chunk)) < size;) {
+                    for (std::uint64_t index = begin; index < std::min(begin + chunk, size); index++) {
+                        work(*chessboard, index, output);
+                    }
+                }
+
+                std::lock_guard lock(merge_mutex);
+                merged.resolved.insert(merged.resolved.end(), output.resolved.begin(), output.resolved.end());
+                merged.deferred.insert(merged.deferred.end(), output.deferred.begin(), output.deferred.end());
+                merged.candidates.insert(merged.candidates.end(), output.candidates.begin(), output.candidates.end());
+            });
+        }
+
+        for (std::thread & worker : workers) {
+            worker.join();
+        }
+        return merged;
+    }
+
+    // stores the value of a position decided in at most pass plies, a position decided further away is put off
+    void resolve(board & chessboard, table_values & table, std::uint64_t index, int pass, pass_output & output) {
+        std::atomic_ref value(table.values[index]);
+        if (value.load(std::memory_order_relaxed) != TB_UNKNOWN) {
+            return;
+        }
+
+        if (!set_up(chessboard, table.layout, index)) {
+            value.store(0, std::memory_order_relaxed);
+            return;
+        }
+
+        const std::int8_t result = chessboard.get_side() == White ? position_search<White>(chessboard)
+                                                                 : position_search<Black>(chessboard);
+        if (result == TB_UNKNOWN) {
+            return;
+        }
+
+        if (tb_plies(result) <= pass) {
+            value.store(result, std::memory_order_relaxed);
+            output.resolved.push_back(index);
+        } else {
+            output.deferred.emplace_back(tb_plies(result), index);
+        }
+    }
+
+    // The unresolved positions of the table with a move to the position of the index. Moves inside a table neither
+    // capture nor promote, so taking one back only moves a man of the side that played it to an empty square. A move
+    // to a lost position wins one ply later, as any faster win was found in an earlier pass, except for a double pawn
+    // push that allows en passant, so those positions are searched like the ones before a win or a draw.
+    void add_predecessors(table_values & table, std::uint64_t index, pass_output & output) const {
+        const tb_layout & layout = table.layout;
+        const int men = layout.men();
+        tb_squares squares;
+        const Color mover = static_cast<Color>(!tb_decode(index, squares, men));
+        const std::int8_t value = table.values[index];
+
+        std::uint64_t occupancy = 0;
+        for (int man = 0; man < men; man++) {
+            occupancy |= bb(squares[man]);
+        }
+
+        const int black_men = 2 + static_cast<int>(layout.white.size());
+        for (int man = 0; man < men; man++) {
+            const Color color = man == 0 || (man > 1 && man < black_men) ? White : Black;
+            if (color != mover) {
+                continue;
+            }
+
+            const Piece piece = man < 2 ? King : man < black_men ? layout.white[man - 2] : layout.black[man - black_men];
+            const Square square = squares[man];
+            std::uint64_t origins = 0;
+            std::uint64_t double_push = 0;
+            switch (piece) {
+                case Pawn: {
+                    const int back = mover == White ? -8 : 8;
+                    const int start_rank = mover == White ? 1 : 6;
+                    const int origin = square + back;
+                    if (origin / 8 >= 1 && origin / 8 <= 6 && !(occupancy & bb(static_cast<Square>(origin)))) {
+                        origins |= bb(static_cast<Square>(origin));
+                        if (origin / 8 + back / 8 == start_rank && !(occupancy & bb(static_cast<Square>(origin + back)))) {
+                            double_push = bb(static_cast<Square>(origin + back));
+                        }
+                    }
+                    break;
+                }
+                case Knight: origins = KNIGHT_ATTACKS[square] & ~occupancy; break;
+                case Bishop: origins = attacks<Ray::BISHOP>(square, occupancy) & ~occupancy; break;
+                case Rook: origins = attacks<Ray::ROOK>(square, occupancy) & ~occupancy; break;
+                case Queen: origins = attacks<Ray::QUEEN>(square, occupancy) & ~occupancy; break;
+                default: origins = KING_ATTACKS[square] & ~occupancy; break;
+            }
+
+            for (origins |= double_push; origins;) {
+                tb_squares before = squares;
+                before[man] = pop_lsb(origins);
+                const bool searched = value >= 0 || (bb(before[man]) & double_push);
+                for_each_index(table, mover, before, [&](std::uint64_t predecessor) {
+                    std::int8_t unknown = TB_UNKNOWN;
+                    if (searched) {
+                        if (std::atomic_ref(table.values[predecessor]).load(std::memory_order_relaxed) == TB_UNKNOWN) {
+                            output.candidates.push_back(predecessor);
+                        }
+                    } else if (std::atomic_ref(table.values[predecessor]).compare_exchange_strong(unknown, tb_win(tb_plies(value) + 1))) {
+                        output.resolved.push_back(predecessor);
+                    }
+                });
+            }
+        }
+    }
+
+    // with four men at most only the two white men can be the same piece, the table holds the position under both orders
+    template <typename Visit>
+    static void for_each_index(const table_values & table, Color side, tb_squares squares, Visit visit) {
+        const int men = table.layout.men();
+        const bool same_men = table.layout.white.size() == 2 && table.layout.white[0] == table.layout.white[1];
+        for (int order = 0; order <= same_men; order++) {
+            visit(tb_index(side, squares, men));
+            std::swap(squares[2], squares[3]);
+        }
+    }
+
+    // places the men of the index, false for overlapping men, pawns on the last ranks and the side not to move in check
+    static bool set_up(board & chessboard, const tb_layout & layout, std::uint64_t index) {
+        const int men = layout.men();
+        tb_squares squares;
+        const Color side = tb_decode(index, squares, men);
+
+        std::uint64_t used = 0;
+        for (int i = 0; i < men; i++) {
+            if (used & bb(squares[i])) {
+                return false;
+            }
+            used |= bb(squares[i]);
+        }
+
+        chessboard.clear(side);
+        chessboard.put_piece(White, King, squares[0]);
+        chessboard.put_piece(Black, King, squares[1]);
+
+        int man = 2;
+        for (const auto & [color, pieces] : {std::pair(White, &layout.white), std::pair(Black, &layout.black)}) {
+            for (const Piece piece : *pieces) {
+                const Square square = squares[man++];
+                if (piece == Pawn && (square < A2 || square > H7)) {
+                    return false;
+                }
+                chessboard.put_piece(color, piece, square);
+            }
+        }
+
+        return side == White ? !chessboard.attackers<Black>(squares[1], chessboard.get_occupancy())
+                             : !chessboard.attackers<White>(squares[0], chessboard.get_occupancy());
+    }
+
+    // value of the position for its side to move as the tables store it
+    template <Color side>
+    std::int8_t position_value(board & chessboard) {
+        if (chessboard.enpassant_square() != Null_Square) {
+            return position_search<side>(chessboard); // the tables have no en passant rights
+        }
+        if (popcount(chessboard.get_occupancy()) == 2) {
+            return 0;
+        }
+
+        const auto & [table, flipped] = lookup.at(chessboard.get_material_key());
+        const Color table_side = flipped ? static_cast<Color>(!side) : side;
+        const std::uint64_t index = tb_index(table_side, tb_board_squares(chessboard, table->layout, flipped), table->layout.men());
+        return std::atomic_ref(table->values[index]).load(std::memory_order_relaxed);
+    }
+
+    // value of the position from the values after its moves, unknown while it depends on unresolved positions
+    template <Color side>
+    std::int8_t position_search(board & chessboard) {
+        constexpr Color enemy = side == White ? Black : White;
+
+        stack_move_list moves;
+        generate_all_moves<side>(chessboard, moves);
+        if (moves.size() == 0) {
+            return chessboard.in_check() ? tb_loss(0) : 0;
+        }
+
+        int fastest_win = INT_MAX;
+        int slowest_loss = 0;
+        bool unknown = false;
+        bool draw = false;
+
+        for (const chess_move & move : moves) {
+            make_move<side, false>(chessboard, move);
+            const std::int8_t value = position_value<enemy>(chessboard);
+            undo_move<side, false>(chessboard, move);
+
+            if (value == TB_UNKNOWN) {
+                unknown = true;
+            } else if (value < 0) {
+                fastest_win = std::min(fastest_win, tb_plies(value) + 1);
+            } else if (value > 0) {
+                slowest_loss = std::max(slowest_loss, tb_plies(value) + 1);
+            } else {
+                draw = true;
+            }
+        }
+
+        if (fastest_win != INT_MAX) {
+            return tb_win(fastest_win);
+        }
+        if (unknown) {
+            return TB_UNKNOWN;
+        }
+        return draw ? 0 : tb_loss(slowest_loss);
+    }
+};
+
+// writes the tables with up to max_men men to the directory
+void generate_tablebases(const std::string & directory, unsigned int threads, bool with_dtm, int max_men = TB_MAX_MEN) {
+    std::filesystem::create_directories(directory);
+    tablebase_generator generator(threads);
+
+    for (const tb_layout & layout : tablebase_layouts(max_men)) {
+        const auto start = std::chrono::steady_clock::now();
+        const int plies = generator.generate(layout);
+        if (!generator.write(directory, layout, with_dtm)) {
+            std::cout << "info string could not write " << layout.name << std::endl;
+            return;
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << layout.name << " longest win " << plies << " plies, " << elapsed.count() << " ms" << std::endl;
+    }
+}
+
+#endif //MOTOR_TABLEBASE_GENERATOR_HPP
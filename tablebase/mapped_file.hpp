@@ -0,0 +1,89 @@
+#ifndef MOTOR_MAPPED_FILE_HPP
+#define MOTOR_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read only view of a file, mapped so that it is paged in on demand and shared between processes
+class mapped_file {
+public:
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        close();
+    }
+
+    void close() {
+#ifdef _WIN32
+        buffer = {};
+#else
+        if (bytes) {
+            munmap(const_cast<std::uint8_t *>(bytes), length);
+        }
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    bool open(const std::string & path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+#else
+        const int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            return false;
+        }
+
+        struct stat info {};
+        void * mapping = MAP_FAILED;
+        if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+            mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        }
+        ::close(descriptor);
+
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        bytes = static_cast<const std::uint8_t *>(mapping);
+        length = info.st_size;
+        return true;
+#endif
+    }
+
+    [[nodiscard]] const std::uint8_t * data() const {
+        return bytes;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return length;
+    }
+
+private:
+    const std::uint8_t * bytes = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    std::vector<std::uint8_t> buffer;
+#endif
+};
+
+#endif //MOTOR_MAPPED_FILE_HPP
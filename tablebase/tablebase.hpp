@@ -0,0 +1,241 @@
+#ifndef MOTOR_TABLEBASE_HPP
+#define MOTOR_TABLEBASE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "../chess_board/board.hpp"
+
+constexpr int TB_MAX_MEN = 4;
+
+// tablebase wins score below the mates, so that the search still prefers a mate it can see
+constexpr std::int16_t TB_WIN = 18'000;
+
+enum class WDL : std::uint8_t {
+    DRAW, WIN, LOSS, FAILED
+};
+
+// squares of the men in table order: white king, black king, white pieces and black pieces
+using tb_squares = std::array<Square, TB_MAX_MEN>;
+
+// One material configuration, the stronger side is always white and the pieces go from the strongest
+struct tb_layout {
+    std::string name;
+    std::vector<Piece> white; // without the kings
+    std::vector<Piece> black;
+
+    [[nodiscard]] int men() const {
+        return 2 + static_cast<int>(white.size() + black.size());
+    }
+
+    // side to move, white king on the files a-d and all squares for the other men
+    [[nodiscard]] std::uint64_t size() const {
+        return 2ull * 32ull << (6 * (men() - 1));
+    }
+
+    // the material key of board, flipped tables have the colours of the pieces swapped
+    [[nodiscard]] std::uint64_t material_key(bool flipped) const {
+        zobrist key;
+        auto add_side = [&](Color color, const std::vector<Piece> & pieces) {
+            std::array<int, 6> counts = {};
+            key.update_psqt_hash(color, King, static_cast<Square>(0));
+            for (const Piece piece : pieces) {
+                key.update_psqt_hash(color, piece, static_cast<Square>(counts[piece]++));
+            }
+        };
+        add_side(flipped ? Black : White, white);
+        add_side(flipped ? White : Black, black);
+        return key.get_key();
+    }
+};
+
+// all tables with up to max_men men, a table comes after every table its captures and promotions lead to
+std::vector<tb_layout> tablebase_layouts(int max_men = TB_MAX_MEN) {
+    constexpr std::array<Piece, 5> order = {Queen, Rook, Bishop, Knight, Pawn};
+    constexpr std::array<char, 5> letters = {'P', 'N', 'B', 'R', 'Q'};
+
+    std::vector<tb_layout> layouts;
+    auto add = [&](std::vector<Piece> white, std::vector<Piece> black) {
+        tb_layout layout {"K", std::move(white), std::move(black)};
+        for (const Piece piece : layout.white) layout.name += letters[piece];
+        layout.name += "vK";
+        for (const Piece piece : layout.black) layout.name += letters[piece];
+        layouts.push_back(std::move(layout));
+    };
+
+    for (const Piece piece : order) {
+        add({piece}, {});
+    }
+
+    if (max_men >= 4) {
+        for (std::size_t first = 0; first < order.size(); first++) {
+            for (std::size_t second = first; second < order.size(); second++) {
+                add({order[first], order[second]}, {});
+                add({order[first]}, {order[second]});
+            }
+        }
+    }
+
+    auto pawns = [](const tb_layout & layout) {
+        return std::ranges::count(layout.white, Pawn) + std::ranges::count(layout.black, Pawn);
+    };
+    std::ranges::stable_sort(layouts, [&](const tb_layout & a, const tb_layout & b) {
+        return std::pair(a.men(), pawns(a)) < std::pair(b.men(), pawns(b));
+    });
+
+    return layouts;
+}
+
+std::uint64_t tb_index(Color side_to_move, tb_squares squares, int men) {
+    if (squares[0] % 8 > 3) {
+        for (int i = 0; i < men; i++) {
+            squares[i] = static_cast<Square>(squares[i] ^ 7);
+        }
+    }
+
+    std::uint64_t index = side_to_move * 32 + squares[0] / 8 * 4 + squares[0] % 8;
+    for (int i = 1; i < men; i++) {
+        index = index * 64 + squares[i];
+    }
+    return index;
+}
+
+Color tb_decode(std::uint64_t index, tb_squares & squares, int men) {
+    for (int i = men - 1; i > 0; i--) {
+        squares[i] = static_cast<Square>(index & 63);
+        index >>= 6;
+    }
+    squares[0] = static_cast<Square>(index % 32 / 4 * 8 + index % 4);
+    return static_cast<Color>(index / 32);
+}
+
+// the men of the board in table order, a flipped table sees the board upside down
+tb_squares tb_board_squares(const board & chessboard, const tb_layout & layout, bool flipped) {
+    const Color white = flipped ? Black : White;
+    const Color black = flipped ? White : Black;
+    const int flip = flipped ? 56 : 0;
+
+    std::array<std::array<std::uint64_t, 6>, 2> remaining = {};
+    for (const Piece piece : {Pawn, Knight, Bishop, Rook, Queen}) {
+        remaining[White][piece] = chessboard.get_pieces(white, piece);
+        remaining[Black][piece] = chessboard.get_pieces(black, piece);
+    }
+
+    tb_squares squares = {};
+    squares[0] = static_cast<Square>(lsb(chessboard.get_pieces(white, King)) ^ flip);
+    squares[1] = static_cast<Square>(lsb(chessboard.get_pieces(black, King)) ^ flip);
+
+    int men = 2;
+    for (const Piece piece : layout.white) {
+        squares[men++] = static_cast<Square>(pop_lsb(remaining[White][piece]) ^ flip);
+    }
+    for (const Piece piece : layout.black) {
+        squares[men++] = static_cast<Square>(pop_lsb(remaining[Black][piece]) ^ flip);
+    }
+    return squares;
+}
+
+// Win/draw/loss tables with two bits per position and optional distance to mate tables with a byte per position,
+// as written by the generator. The tables are not modified after loading, so all threads can probe them without locks.
+class tablebase {
+public:
+    // loads all tables found in the directory and returns their number
+    int load(const std::string & directory) {
+        tables.clear();
+        lookup.clear();
+        largest = 0;
+
+        for (tb_layout & layout : tablebase_layouts()) {
+            auto entry = std::make_unique<table>();
+            const std::string path = directory + "/" + layout.name;
+            if (!entry->wdl.open(path + ".wdl") || entry->wdl.size() != (layout.size() + 3) / 4) {
+                continue;
+            }
+            // a broken distance to mate file leaves the table without distances, the win/draw/loss file still counts
+            if (entry->dtm.open(path + ".dtm") && entry->dtm.size() != layout.size()) {
+                entry->dtm.close();
+            }
+
+            largest = std::max(largest, layout.men());
+            lookup.emplace(layout.material_key(false), std::pair(entry.get(), false));
+            lookup.emplace(layout.material_key(true), std::pair(entry.get(), true));
+            entry->layout = std::move(layout);
+            tables.push_back(std::move(entry));
+        }
+
+        return static_cast<int>(tables.size());
+    }
+
+    [[nodiscard]] int max_men() const {
+        return largest;
+    }
+
+    [[nodiscard]] WDL probe_wdl(const board & chessboard) const {
+        const table * entry;
+        std::uint64_t index;
+        if (!find(chessboard, entry, index)) {
+            return WDL::FAILED;
+        }
+
+        const std::uint8_t value = (entry->wdl.data()[index / 4] >> (index % 4 * 2)) & 3;
+        return static_cast<WDL>(value);
+    }
+
+    // plies to mate for the side to move, zero for draws
+    [[nodiscard]] WDL probe_dtm(const board & chessboard, int & plies) const {
+        const table * entry;
+        std::uint64_t index;
+        if (!find(chessboard, entry, index) || !entry->dtm.data()) {
+            return WDL::FAILED;
+        }
+
+        const auto value = static_cast<std::int8_t>(entry->dtm.data()[index]);
+        plies = std::abs(value) - 1;
+        if (value == 0) {
+            plies = 0;
+            return WDL::DRAW;
+        }
+        return value > 0 ? WDL::WIN : WDL::LOSS;
+    }
+
+private:
+    struct table {
+        tb_layout layout;
+        mapped_file wdl;
+        mapped_file dtm;
+    };
+
+    std::vector<std::unique_ptr<table>> tables;
+    std::unordered_map<std::uint64_t, std::pair<const table *, bool>> lookup;
+    int largest = 0;
+
+    // the tables know neither castling nor en passant
+    bool find(const board & chessboard, const table * & entry, std::uint64_t & index) const {
+        if (popcount(chessboard.get_occupancy()) > largest || chessboard.has_castling_rights()
+            || chessboard.enpassant_square() != Null_Square) {
+            return false;
+        }
+
+        const auto it = lookup.find(chessboard.get_material_key());
+        if (it == lookup.end()) {
+            return false;
+        }
+
+        const auto [found, flipped] = it->second;
+        const Color side = flipped ? static_cast<Color>(!chessboard.get_side()) : chessboard.get_side();
+        entry = found;
+        index = tb_index(side, tb_board_squares(chessboard, found->layout, flipped), found->layout.men());
+        return true;
+    }
+};
+
+tablebase tablebases;
+
+#endif //MOTOR_TABLEBASE_HPP